@@ -0,0 +1,112 @@
+#ifndef BSY_UNISTOR_HOST_ARDUINO_H
+#define BSY_UNISTOR_HOST_ARDUINO_H
+
+// Хост-бэкенд: минимум Arduino-ESP32, который нужен библиотеке и скетчам-тестам
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstdarg>
+#include <algorithm>
+#include <new>
+#include "BSY_UNISTOR_host_sim.h"
+#include "esp_system.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#define IRAM_ATTR
+#define RTC_NOINIT_ATTR
+#define RTC_DATA_ATTR
+
+inline uint32_t millis() { return StorageSim::millis(); }
+inline uint32_t micros() { return (uint32_t)StorageSim::micros(); }
+inline void delay(uint32_t ms) { StorageSim::advance(ms); }
+inline void yield() { std::this_thread::yield(); }
+
+// CRC32 из ROM ESP32 (полином 0xEDB88320)
+extern "C" inline uint32_t crc32_le(uint32_t crc, unsigned char const* p, size_t len) {
+    crc = ~crc;
+    while (len--) {
+        crc ^= *p++;
+        for (int k = 0; k < 8; k++) crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+    }
+    return ~crc;
+}
+
+class String {
+private:
+    std::string _s;
+public:
+    String(const char* s = "") : _s(s ? s : "") {}
+    String(const std::string& s) : _s(s) {}
+    explicit String(int v) : _s(std::to_string(v)) {}
+    explicit String(unsigned v) : _s(std::to_string(v)) {}
+    explicit String(long v) : _s(std::to_string(v)) {}
+    explicit String(unsigned long v) : _s(std::to_string(v)) {}
+    const char* c_str() const { return _s.c_str(); }
+    size_t length() const { return _s.size(); }
+    String operator+(const String& o) const { return String(_s + o._s); }
+    String operator+(const char* o) const { return String(_s + o); }
+    String& operator+=(const String& o) { _s += o._s; return *this; }
+    String& operator+=(const char* o) { _s += o; return *this; }
+    String& operator+=(char c) { _s += c; return *this; }
+    bool operator==(const String& o) const { return _s == o._s; }
+    bool operator!=(const String& o) const { return _s != o._s; }
+    bool operator<(const String& o) const { return _s < o._s; }
+    bool startsWith(const char* p) const { return _s.rfind(p, 0) == 0; }
+    bool endsWith(const char* p) const {
+        size_t n = strlen(p);
+        return _s.size() >= n && _s.compare(_s.size() - n, n, p) == 0;
+    }
+};
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(const uint8_t* buf, size_t len) = 0;
+    size_t write(uint8_t c) { return write(&c, 1); }
+};
+
+/**
+ * Serial - в stdout
+ */
+class StorageSimSerial : public Print {
+public:
+    void begin(unsigned long) {}
+    explicit operator bool() const { return true; }
+    size_t write(const uint8_t* buf, size_t len) override { return fwrite(buf, 1, len, stdout); }
+    using Print::write;
+    __attribute__((format(printf, 2, 3)))
+    int printf(const char* fmt, ...) {
+        va_list args;
+        va_start(args, fmt);
+        int n = vprintf(fmt, args);
+        va_end(args);
+        return n;
+    }
+    size_t print(const char* s) { return fputs(s, stdout) < 0 ? 0 : strlen(s); }
+    size_t print(const String& s) { return print(s.c_str()); }
+    size_t println(const char* s = "") { return print(s) + print("\n"); }
+    size_t println(const String& s) { return println(s.c_str()); }
+    int available() { return 0; }
+    void flush() { fflush(stdout); }
+};
+inline StorageSimSerial Serial;
+
+/**
+ * ESP - куча и перезагрузка
+ */
+class StorageSimEsp {
+public:
+    uint32_t getFreeHeap() { return 200000; }
+    uint32_t getMinFreeHeap() { return 180000; }
+    uint32_t getMaxAllocHeap() { return 110000; }
+    uint32_t getPsramSize() { return 0; }
+    void restart() { esp_restart(); }
+};
+inline StorageSimEsp ESP;
+
+inline bool psramFound() { return false; }
+inline void* ps_malloc(size_t size) { return malloc(size); }
+
+#endif
@@ -0,0 +1,308 @@
+#ifndef BSY_UNISTOR_HOST_SIM_H
+#define BSY_UNISTOR_HOST_SIM_H
+
+/**
+ * Хост-бэкенд: NVS, LittleFS, часы и задачи FreeRTOS в памяти ПК.
+ * Заголовки из host/ подменяют Arduino.h, Preferences.h, LittleFS.h и т.д.,
+ * сама библиотека не меняется:
+ *   g++ -std=gnu++17 -I host -I src test.cpp -lpthread
+ * StorageSim управляет симуляцией: отключение питания на заданном байте записи,
+ * задержки флеша, порча данных, счетчики.
+ */
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <chrono>
+
+/**
+ * Задержки флеша в микросекундах (двигают часы симулятора)
+ */
+struct StorageSimLatency {
+    uint32_t nvsWriteUs = 0;      // одна запись ключа
+    uint32_t nvsReadUs = 0;       // одно чтение ключа
+    uint32_t fsOpUs = 0;          // open/rename/remove
+    uint32_t fsWritePerKbUs = 0;  // запись файла, на 1 КБ
+    uint32_t fsReadPerKbUs = 0;   // чтение файла, на 1 КБ
+};
+
+struct StorageSimStats {
+    uint32_t nvsWrites = 0;
+    uint32_t nvsReads = 0;
+    uint32_t nvsCommits = 0;
+    uint64_t nvsBytes = 0;
+    uint32_t fsOpens = 0;
+    uint64_t fsBytes = 0;
+    uint64_t fsFlashBytes = 0;    // с copy-on-write LittleFS: от блока первой записи до конца файла
+    uint32_t powerLosses = 0;
+};
+
+struct StorageSimNvsEntry {
+    uint8_t type;  // PreferenceType
+    std::vector<uint8_t> data;
+};
+
+/**
+ * @class StorageSim
+ * @brief Состояние симулятора (общее для всех объектов хранилищ)
+ * @code
+ * StorageSim::reset();
+ * StorageSim::cutPowerAfter(100);   // питание пропадет на 101-м байте записи
+ * fsLog.save();                     // запишется не целиком
+ * StorageSim::powerCycle();         // "включение": ESP_RST_POWERON
+ * fsLog.load(resLog);               // проверка восстановления
+ * @endcode
+ */
+class StorageSim {
+public:
+    /**
+     * Что остается в файле, если питание пропало во время записи
+     */
+    enum PowerLoss : uint8_t {
+        TORN,    // байты до точки отказа уже в файле (худший случай - проверка CRC и восстановления)
+        COMMIT   // как в LittleFS: содержимое файла меняется только в flush()/close()
+    };
+
+    typedef StorageSimLatency Latency;
+    typedef StorageSimStats Stats;
+    typedef StorageSimNvsEntry NvsEntry;
+
+    // Данные "флеша" (для проверок в тестах можно читать напрямую)
+    inline static std::map<std::string, std::map<std::string, NvsEntry>> nvs;
+    inline static std::map<std::string, std::vector<uint8_t>> files;
+    inline static std::set<std::string> dirs{ "/" };
+
+private:
+    inline static std::recursive_mutex _mutex;
+    inline static std::atomic<uint64_t> _clockUs{ 0 };
+    inline static Latency _latency;
+    inline static bool _realSleep = false;
+    inline static PowerLoss _mode = TORN;
+    inline static bool _powered = true;
+    inline static bool _armed = false;
+    inline static size_t _budget = 0;    // байт до отключения питания
+    inline static bool _opsArmed = false;
+    inline static size_t _opBudget = 0;  // rename/remove до отключения питания
+    inline static size_t _fsSize = 1536 * 1024;
+    inline static size_t _fsBlock = 4096;
+    inline static int _resetReason = 1;  // ESP_RST_POWERON
+    inline static Stats _stats;
+
+public:
+    static std::recursive_mutex& mutex() { return _mutex; }
+
+    /**
+     * Стереть всё (NVS, файлы, счетчики), часы в 0, питание включено
+     */
+    static void reset() {
+        std::lock_guard<std::recursive_mutex> g(_mutex);
+        nvs.clear();
+        files.clear();
+        dirs = { "/" };
+        _clockUs = 0;
+        _latency = Latency();
+        _realSleep = false;
+        _mode = TORN;
+        _powered = true;
+        _armed = false;
+        _opsArmed = false;
+        _resetReason = 1;
+        _stats = Stats();
+    }
+
+    // --- Питание ---
+
+    /**
+     * Отключить питание через bytes байт записи во флеш (NVS и файлы вместе).
+     * Запись NVS атомарна: ключ, на котором пропало питание, сохраняет прежнее значение
+     */
+    static void cutPowerAfter(size_t bytes) {
+        std::lock_guard<std::recursive_mutex> g(_mutex);
+        _armed = true;
+        _budget = bytes;
+    }
+
+    /**
+     * Отключить питание перед ops+1-м переименованием или удалением файла
+     * (между ними байтовый счетчик cutPowerAfter() отказ не ставит)
+     */
+    static void cutPowerAfterOps(size_t ops) {
+        std::lock_guard<std::recursive_mutex> g(_mutex);
+        _opsArmed = true;
+        _opBudget = ops;
+    }
+
+    /**
+     * Отключить питание сейчас: все записи, удаления и переименования не выполняются
+     */
+    static void cutPower() {
+        std::lock_guard<std::recursive_mutex> g(_mutex);
+        if (_powered) _stats.powerLosses++;
+        _powered = false;
+        _armed = false;
+        _opsArmed = false;
+    }
+
+    static bool powered() { return _powered; }
+
+    /**
+     * Включить питание (перезагрузка). Объекты хранилищ тест создает заново
+     * @param resetReason Причина сброса для esp_reset_reason() (по умолчанию ESP_RST_POWERON)
+     */
+    static void powerCycle(int resetReason = 1) {
+        std::lock_guard<std::recursive_mutex> g(_mutex);
+        _powered = true;
+        _armed = false;
+        _opsArmed = false;
+        _resetReason = resetReason;
+    }
+
+    static void setPowerLossMode(PowerLoss mode) { _mode = mode; }
+    static PowerLoss powerLossMode() { return _mode; }
+
+    static void setResetReason(int reason) { _resetReason = reason; }
+    static int resetReason() { return _resetReason; }
+
+    /**
+     * Сколько из n байт успеет записаться до отключения питания (используют бэкенды).
+     * Если меньше n - питание отключается
+     */
+    static size_t spend(size_t n) {
+        std::lock_guard<std::recursive_mutex> g(_mutex);
+        if (!_powered) return 0;
+        if (!_armed) return n;
+        if (n <= _budget) {
+            _budget -= n;
+            return n;
+        }
+        size_t ok = _budget;
+        _budget = 0;
+        cutPower();
+        return ok;
+    }
+
+    /**
+     * Успеет ли выполниться переименование или удаление файла (используют бэкенды).
+     * Если нет - питание отключается
+     */
+    static bool spendOp() {
+        std::lock_guard<std::recursive_mutex> g(_mutex);
+        if (!_powered) return false;
+        if (!_opsArmed) return true;
+        if (_opBudget) {
+            _opBudget--;
+            return true;
+        }
+        cutPower();
+        return false;
+    }
+
+    // --- Время ---
+
+    /**
+     * Часы симулятора: идут только по delay(), vTaskDelay() и задержкам флеша,
+     * поэтому тесты с дебаунсом в минуты выполняются мгновенно и повторяемо
+     */
+    static uint64_t micros() { return _clockUs; }
+    static uint32_t millis() { return (uint32_t)(_clockUs / 1000); }
+    static void advanceUs(uint64_t us) { _clockUs += us; }
+    static void advance(uint32_t ms) { _clockUs += (uint64_t)ms * 1000; }
+
+    /**
+     * Задержки флеша
+     * @param latency Значения задержек
+     * @param realSleep true - ещё и реально ждать (проверка гонок с фоновой записью)
+     */
+    static void setLatency(const Latency& latency, bool realSleep = false) {
+        _latency = latency;
+        _realSleep = realSleep;
+    }
+
+    static const Latency& latency() { return _latency; }
+
+    /**
+     * Потратить время на операцию флеша (используют бэкенды)
+     */
+    static void busy(uint64_t us) {
+        if (!us) return;
+        _clockUs += us;
+        if (_realSleep) std::this_thread::sleep_for(std::chrono::microseconds(us));
+    }
+
+    static uint64_t perKb(uint32_t usPerKb, size_t bytes) { return (uint64_t)usPerKb * bytes / 1024; }
+
+    // --- Файловая система ---
+
+    /**
+     * Размер раздела LittleFS и блока (занятое место считается целыми блоками)
+     */
+    static void setFsSize(size_t total, size_t block = 4096) {
+        _fsSize = total;
+        _fsBlock = block;
+    }
+
+    static size_t fsSize() { return _fsSize; }
+    static size_t fsBlock() { return _fsBlock; }
+
+    static size_t fsUsed(const std::string* except = nullptr, size_t exceptSize = 0) {
+        std::lock_guard<std::recursive_mutex> g(_mutex);
+        size_t used = 0;
+        for (auto& kv : files) {
+            size_t n = except && kv.first == *except ? exceptSize : kv.second.size();
+            used += (n + _fsBlock - 1) / _fsBlock * _fsBlock;
+        }
+        return used;
+    }
+
+    // --- Порча данных ---
+
+    /**
+     * Испортить байт файла (XOR с mask)
+     * @return false если файла нет или он короче offset
+     */
+    static bool corrupt(const char* path, size_t offset, uint8_t mask = 0xFF) {
+        std::lock_guard<std::recursive_mutex> g(_mutex);
+        auto it = files.find(path);
+        if (it == files.end() || offset >= it->second.size()) return false;
+        it->second[offset] ^= mask;
+        return true;
+    }
+
+    /**
+     * Обрезать файл до len байт
+     */
+    static bool truncate(const char* path, size_t len) {
+        std::lock_guard<std::recursive_mutex> g(_mutex);
+        auto it = files.find(path);
+        if (it == files.end() || len > it->second.size()) return false;
+        it->second.resize(len);
+        return true;
+    }
+
+    /**
+     * Испортить байт значения ключа NVS (XOR с mask)
+     */
+    static bool corruptNvs(const char* ns, const char* key, size_t offset, uint8_t mask = 0xFF) {
+        std::lock_guard<std::recursive_mutex> g(_mutex);
+        auto n = nvs.find(ns);
+        if (n == nvs.end()) return false;
+        auto k = n->second.find(key);
+        if (k == n->second.end() || offset >= k->second.data.size()) return false;
+        k->second.data[offset] ^= mask;
+        return true;
+    }
+
+    // --- Счетчики ---
+
+    static Stats& stats() { return _stats; }
+    static void resetStats() { _stats = Stats(); }
+};
+
+#endif
@@ -0,0 +1,253 @@
+#ifndef BSY_UNISTOR_HOST_LITTLEFS_H
+#define BSY_UNISTOR_HOST_LITTLEFS_H
+
+// Хост-бэкенд: LittleFS поверх StorageSim::files / StorageSim::dirs
+
+#include "Arduino.h"
+#include <memory>
+
+enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+class File {
+private:
+    struct State {
+        std::string path;
+        std::string name;
+        bool dir = false;
+        bool writable = false;
+        bool own = false;              // режим COMMIT: пишем в свою копию до flush()/close()
+        std::vector<uint8_t> copy;
+        size_t pos = 0;
+        size_t dirtyFrom = SIZE_MAX;   // первое записанное место с прошлого flush()/close()
+        std::vector<std::string> children;
+        size_t next = 0;
+    };
+    std::shared_ptr<State> _st;
+
+    std::vector<uint8_t>& data() {
+        return _st->own ? _st->copy : StorageSim::files[_st->path];
+    }
+
+    void commit() {
+        if (!_st || !StorageSim::powered()) return;
+        // LittleFS не переписывает блок на месте: от блока первого измененного места
+        // до конца файла всё копируется в новые блоки
+        if (_st->dirtyFrom != SIZE_MAX) {
+            size_t from = _st->dirtyFrom / StorageSim::fsBlock() * StorageSim::fsBlock();
+            size_t size = data().size();
+            StorageSim::stats().fsFlashBytes += size > from ? size - from : 0;
+            _st->dirtyFrom = SIZE_MAX;
+        }
+        if (_st->own) StorageSim::files[_st->path] = _st->copy;
+    }
+
+public:
+    File() {}
+
+    static File make(const std::string& path, bool dir, bool writable, bool truncate, bool append) {
+        File f;
+        f._st = std::make_shared<State>();
+        State& st = *f._st;
+        st.path = path;
+        st.name = path.substr(path.find_last_of('/') + 1);
+        st.dir = dir;
+        st.writable = writable;
+        if (dir) {
+            std::string prefix = path == "/" ? "/" : path + "/";
+            auto direct = [&](const std::string& p) {
+                return p != path && p.rfind(prefix, 0) == 0 && p.find('/', prefix.size()) == std::string::npos;
+            };
+            for (auto& kv : StorageSim::files) if (direct(kv.first)) st.children.push_back(kv.first);
+            for (auto& d : StorageSim::dirs) if (direct(d)) st.children.push_back(d);
+            return f;
+        }
+        if (writable && StorageSim::powerLossMode() == StorageSim::COMMIT) {
+            st.own = true;
+            auto it = StorageSim::files.find(path);
+            if (it != StorageSim::files.end() && !truncate) st.copy = it->second;
+        } else if (truncate) {
+            StorageSim::files[path].clear();
+        } else {
+            StorageSim::files[path];
+        }
+        if (append) st.pos = f.data().size();
+        return f;
+    }
+
+    explicit operator bool() const { return (bool)_st; }
+    bool isDirectory() const { return _st && _st->dir; }
+    const char* name() const { return _st ? _st->name.c_str() : ""; }
+    const char* path() const { return _st ? _st->path.c_str() : ""; }
+
+    size_t size() {
+        if (!_st || _st->dir) return 0;
+        std::lock_guard<std::recursive_mutex> g(StorageSim::mutex());
+        return data().size();
+    }
+
+    size_t position() const { return _st ? _st->pos : 0; }
+
+    bool seek(uint32_t pos, SeekMode mode = SeekSet) {
+        if (!_st) return false;
+        size_t base = mode == SeekSet ? 0 : mode == SeekCur ? _st->pos : size();
+        if (base + pos > size()) return false;
+        _st->pos = base + pos;
+        return true;
+    }
+
+    int available() { return _st && !_st->dir ? (int)(size() - std::min(_st->pos, size())) : 0; }
+
+    size_t read(uint8_t* buf, size_t len) {
+        if (!_st || _st->dir) return 0;
+        std::lock_guard<std::recursive_mutex> g(StorageSim::mutex());
+        std::vector<uint8_t>& v = data();
+        if (_st->pos >= v.size()) return 0;
+        len = std::min(len, v.size() - _st->pos);
+        memcpy(buf, v.data() + _st->pos, len);
+        _st->pos += len;
+        StorageSim::busy(StorageSim::perKb(StorageSim::latency().fsReadPerKbUs, len));
+        return len;
+    }
+
+    int read() {
+        uint8_t c;
+        return read(&c, 1) == 1 ? c : -1;
+    }
+
+    size_t write(const uint8_t* buf, size_t len) {
+        if (!_st || !_st->writable) return 0;
+        std::lock_guard<std::recursive_mutex> g(StorageSim::mutex());
+        std::vector<uint8_t>& v = data();
+        // Место на разделе: занятое считается целыми блоками. Если не хватает -
+        // дописывается то, что влезло в свободные блоки (короткая запись)
+        size_t end = std::max(v.size(), _st->pos + len);
+        if (StorageSim::fsUsed(&_st->path, end) > StorageSim::fsSize()) {
+            size_t others = StorageSim::fsUsed(&_st->path, 0);
+            size_t room = StorageSim::fsSize() > others
+                ? (StorageSim::fsSize() - others) / StorageSim::fsBlock() * StorageSim::fsBlock() : 0;
+            len = room > _st->pos ? std::min(len, room - _st->pos) : 0;
+            if (!len) return 0;
+        }
+        len = StorageSim::spend(len);
+        if (v.size() < _st->pos + len) v.resize(_st->pos + len);
+        memcpy(v.data() + _st->pos, buf, len);
+        _st->dirtyFrom = std::min(_st->dirtyFrom, _st->pos);
+        _st->pos += len;
+        StorageSim::stats().fsBytes += len;
+        StorageSim::busy(StorageSim::perKb(StorageSim::latency().fsWritePerKbUs, len));
+        return len;
+    }
+
+    size_t write(uint8_t c) { return write(&c, 1); }
+
+    void flush() {
+        std::lock_guard<std::recursive_mutex> g(StorageSim::mutex());
+        commit();
+    }
+
+    void close() {
+        if (!_st) return;
+        std::lock_guard<std::recursive_mutex> g(StorageSim::mutex());
+        commit();
+        _st.reset();
+    }
+
+    File openNextFile() {
+        if (!_st || _st->next >= _st->children.size()) return File();
+        std::lock_guard<std::recursive_mutex> g(StorageSim::mutex());
+        const std::string& p = _st->children[_st->next++];
+        return make(p, StorageSim::dirs.count(p) > 0, false, false, false);
+    }
+};
+
+class StorageSimLittleFS {
+private:
+    bool _mounted = false;
+
+    static void op() {
+        StorageSim::busy(StorageSim::latency().fsOpUs);
+        StorageSim::stats().fsOpens++;
+    }
+
+public:
+    bool begin(bool = false, const char* = "/littlefs", uint8_t = 10, const char* = "spiffs") {
+        _mounted = true;
+        return true;
+    }
+
+    void end() { _mounted = false; }
+
+    bool format() {
+        if (!StorageSim::powered()) return false;
+        std::lock_guard<std::recursive_mutex> g(StorageSim::mutex());
+        StorageSim::files.clear();
+        StorageSim::dirs = { "/" };
+        return true;
+    }
+
+    size_t totalBytes() { return StorageSim::fsSize(); }
+    size_t usedBytes() { return StorageSim::fsUsed(); }
+
+    File open(const char* path, const char* mode = "r", bool = false) {
+        std::lock_guard<std::recursive_mutex> g(StorageSim::mutex());
+        std::string p(path);
+        op();
+        if (StorageSim::dirs.count(p)) return File::make(p, true, false, false, false);
+        bool exists = StorageSim::files.count(p) > 0;
+        if (mode[0] == 'r') {
+            if (!exists) return File();
+            return File::make(p, false, mode[1] == '+', false, false);
+        }
+        if (!StorageSim::powered()) return File();
+        if (mode[0] == 'w') return File::make(p, false, true, true, false);
+        if (mode[0] == 'a') return File::make(p, false, true, false, true);
+        return File();
+    }
+    File open(const String& path, const char* mode = "r", bool create = false) { return open(path.c_str(), mode, create); }
+
+    bool exists(const char* path) {
+        std::lock_guard<std::recursive_mutex> g(StorageSim::mutex());
+        return StorageSim::files.count(path) || StorageSim::dirs.count(path);
+    }
+    bool exists(const String& path) { return exists(path.c_str()); }
+
+    bool remove(const char* path) {
+        if (!StorageSim::spendOp()) return false;
+        std::lock_guard<std::recursive_mutex> g(StorageSim::mutex());
+        op();
+        return StorageSim::files.erase(path) > 0;
+    }
+    bool remove(const String& path) { return remove(path.c_str()); }
+
+    // Переименование атомарно, как в LittleFS: прежний dst заменяется целиком
+    bool rename(const char* from, const char* to) {
+        if (!StorageSim::spendOp()) return false;
+        std::lock_guard<std::recursive_mutex> g(StorageSim::mutex());
+        op();
+        auto it = StorageSim::files.find(from);
+        if (it == StorageSim::files.end()) return false;
+        std::vector<uint8_t> data = std::move(it->second);
+        StorageSim::files.erase(it);
+        StorageSim::files[to] = std::move(data);
+        return true;
+    }
+    bool rename(const String& from, const String& to) { return rename(from.c_str(), to.c_str()); }
+
+    bool mkdir(const char* path) {
+        if (!StorageSim::powered()) return false;
+        std::lock_guard<std::recursive_mutex> g(StorageSim::mutex());
+        StorageSim::dirs.insert(path);
+        return true;
+    }
+    bool mkdir(const String& path) { return mkdir(path.c_str()); }
+
+    bool rmdir(const char* path) {
+        if (!StorageSim::powered()) return false;
+        std::lock_guard<std::recursive_mutex> g(StorageSim::mutex());
+        return StorageSim::dirs.erase(path) > 0;
+    }
+    bool rmdir(const String& path) { return rmdir(path.c_str()); }
+};
+inline StorageSimLittleFS LittleFS;
+
+#endif
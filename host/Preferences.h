@@ -0,0 +1,140 @@
+#ifndef BSY_UNISTOR_HOST_PREFERENCES_H
+#define BSY_UNISTOR_HOST_PREFERENCES_H
+
+// Хост-бэкенд: Preferences поверх StorageSim::nvs.
+// Как и NVS, запись ключа атомарна: при отключении питания остается прежнее значение
+
+#include "Arduino.h"
+
+typedef enum {
+    PT_I8, PT_U8, PT_I16, PT_U16, PT_I32, PT_U32, PT_I64, PT_U64, PT_STR, PT_BLOB, PT_INVALID
+} PreferenceType;
+
+class Preferences {
+private:
+    std::string _ns;
+    bool _started = false;
+    bool _readOnly = true;
+
+    static constexpr size_t KEY_MAX = 15;
+
+    StorageSim::NvsEntry* find(const char* key) {
+        if (!_started || !key) return nullptr;
+        auto n = StorageSim::nvs.find(_ns);
+        if (n == StorageSim::nvs.end()) return nullptr;
+        auto k = n->second.find(key);
+        return k == n->second.end() ? nullptr : &k->second;
+    }
+
+    size_t put(const char* key, const void* value, size_t len, PreferenceType type) {
+        if (!_started || _readOnly || !key || strlen(key) > KEY_MAX || !len) return 0;
+        std::lock_guard<std::recursive_mutex> g(StorageSim::mutex());
+        StorageSim::busy(StorageSim::latency().nvsWriteUs);
+        if (StorageSim::spend(len) != len) return 0;  // питание пропало - ключ не изменился
+        const uint8_t* p = (const uint8_t*)value;
+        StorageSim::nvs[_ns][key] = StorageSim::NvsEntry{ (uint8_t)type, std::vector<uint8_t>(p, p + len) };
+        StorageSim::stats().nvsWrites++;
+        StorageSim::stats().nvsCommits++;  // Preferences коммитит каждую запись
+        StorageSim::stats().nvsBytes += len;
+        return len;
+    }
+
+    template <typename V>
+    V get(const char* key, V def) {
+        std::lock_guard<std::recursive_mutex> g(StorageSim::mutex());
+        StorageSim::NvsEntry* e = find(key);
+        if (!e || e->data.size() != sizeof(V)) return def;
+        StorageSim::busy(StorageSim::latency().nvsReadUs);
+        StorageSim::stats().nvsReads++;
+        V v;
+        memcpy(&v, e->data.data(), sizeof(V));
+        return v;
+    }
+
+public:
+    bool begin(const char* name, bool readOnly = false, const char* = nullptr) {
+        if (_started || !name || strlen(name) > KEY_MAX) return false;
+        std::lock_guard<std::recursive_mutex> g(StorageSim::mutex());
+        if (readOnly && !StorageSim::nvs.count(name)) return false;  // как nvs_open: неймспейса нет
+        if (!readOnly && !StorageSim::powered()) return false;
+        if (!readOnly) StorageSim::nvs[name];
+        _ns = name;
+        _readOnly = readOnly;
+        _started = true;
+        return true;
+    }
+
+    void end() { _started = false; }
+
+    bool clear() {
+        if (!_started || _readOnly || !StorageSim::powered()) return false;
+        std::lock_guard<std::recursive_mutex> g(StorageSim::mutex());
+        StorageSim::nvs[_ns].clear();
+        StorageSim::stats().nvsCommits++;
+        return true;
+    }
+
+    bool remove(const char* key) {
+        if (!_started || _readOnly || !StorageSim::powered()) return false;
+        std::lock_guard<std::recursive_mutex> g(StorageSim::mutex());
+        StorageSim::stats().nvsCommits++;
+        return StorageSim::nvs[_ns].erase(key) > 0;
+    }
+
+    bool isKey(const char* key) {
+        std::lock_guard<std::recursive_mutex> g(StorageSim::mutex());
+        return find(key) != nullptr;
+    }
+
+    PreferenceType getType(const char* key) {
+        std::lock_guard<std::recursive_mutex> g(StorageSim::mutex());
+        StorageSim::NvsEntry* e = find(key);
+        return e ? (PreferenceType)e->type : PT_INVALID;
+    }
+
+    size_t freeEntries() { return 1000; }
+
+    size_t putChar(const char* key, int8_t v) { return put(key, &v, sizeof(v), PT_I8); }
+    size_t putUChar(const char* key, uint8_t v) { return put(key, &v, sizeof(v), PT_U8); }
+    size_t putShort(const char* key, int16_t v) { return put(key, &v, sizeof(v), PT_I16); }
+    size_t putUShort(const char* key, uint16_t v) { return put(key, &v, sizeof(v), PT_U16); }
+    size_t putInt(const char* key, int32_t v) { return put(key, &v, sizeof(v), PT_I32); }
+    size_t putUInt(const char* key, uint32_t v) { return put(key, &v, sizeof(v), PT_U32); }
+    size_t putLong64(const char* key, int64_t v) { return put(key, &v, sizeof(v), PT_I64); }
+    size_t putULong64(const char* key, uint64_t v) { return put(key, &v, sizeof(v), PT_U64); }
+    size_t putBool(const char* key, bool v) { return putUChar(key, v ? 1 : 0); }
+    size_t putFloat(const char* key, float v) { return put(key, &v, sizeof(v), PT_BLOB); }
+    size_t putDouble(const char* key, double v) { return put(key, &v, sizeof(v), PT_BLOB); }
+    size_t putBytes(const char* key, const void* value, size_t len) { return put(key, value, len, PT_BLOB); }
+
+    int8_t getChar(const char* key, int8_t def = 0) { return get(key, def); }
+    uint8_t getUChar(const char* key, uint8_t def = 0) { return get(key, def); }
+    int16_t getShort(const char* key, int16_t def = 0) { return get(key, def); }
+    uint16_t getUShort(const char* key, uint16_t def = 0) { return get(key, def); }
+    int32_t getInt(const char* key, int32_t def = 0) { return get(key, def); }
+    uint32_t getUInt(const char* key, uint32_t def = 0) { return get(key, def); }
+    int64_t getLong64(const char* key, int64_t def = 0) { return get(key, def); }
+    uint64_t getULong64(const char* key, uint64_t def = 0) { return get(key, def); }
+    bool getBool(const char* key, bool def = false) { return getUChar(key, def ? 1 : 0) != 0; }
+    float getFloat(const char* key, float def = 0) { return get(key, def); }
+    double getDouble(const char* key, double def = 0) { return get(key, def); }
+
+    size_t getBytesLength(const char* key) {
+        std::lock_guard<std::recursive_mutex> g(StorageSim::mutex());
+        StorageSim::NvsEntry* e = find(key);
+        return e ? e->data.size() : 0;
+    }
+
+    // Как в Arduino-ESP32: буфер меньше значения - ошибка, 0
+    size_t getBytes(const char* key, void* buf, size_t maxLen) {
+        std::lock_guard<std::recursive_mutex> g(StorageSim::mutex());
+        StorageSim::NvsEntry* e = find(key);
+        if (!e || e->data.size() > maxLen) return 0;
+        StorageSim::busy(StorageSim::latency().nvsReadUs);
+        StorageSim::stats().nvsReads++;
+        memcpy(buf, e->data.data(), e->data.size());
+        return e->data.size();
+    }
+};
+
+#endif
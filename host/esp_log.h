@@ -0,0 +1,18 @@
+#ifndef BSY_UNISTOR_HOST_ESP_LOG_H
+#define BSY_UNISTOR_HOST_ESP_LOG_H
+
+#include <cstdio>
+#include <cstdarg>
+
+typedef enum {
+    ESP_LOG_NONE, ESP_LOG_ERROR, ESP_LOG_WARN, ESP_LOG_INFO, ESP_LOG_DEBUG, ESP_LOG_VERBOSE
+} esp_log_level_t;
+
+inline void esp_log_write(esp_log_level_t, const char*, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    vprintf(fmt, args);
+    va_end(args);
+}
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef BSY_UNISTOR_HOST_ESP_RANDOM_H
+#define BSY_UNISTOR_HOST_ESP_RANDOM_H
+
+#include <cstdint>
+
+// Псевдослучайные числа (xorshift): одинаковая последовательность при каждом запуске
+inline uint32_t esp_random() {
+    static uint32_t x = 0x2545F491;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return x;
+}
+
+#endif
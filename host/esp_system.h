@@ -0,0 +1,51 @@
+#ifndef BSY_UNISTOR_HOST_ESP_SYSTEM_H
+#define BSY_UNISTOR_HOST_ESP_SYSTEM_H
+
+#include "BSY_UNISTOR_host_sim.h"
+
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+
+typedef enum {
+    ESP_RST_UNKNOWN, ESP_RST_POWERON, ESP_RST_EXT, ESP_RST_SW, ESP_RST_PANIC, ESP_RST_INT_WDT,
+    ESP_RST_TASK_WDT, ESP_RST_WDT, ESP_RST_DEEPSLEEP, ESP_RST_BROWNOUT, ESP_RST_SDIO
+} esp_reset_reason_t;
+
+// Причину задает StorageSim::powerCycle() / setResetReason()
+inline esp_reset_reason_t esp_reset_reason() { return (esp_reset_reason_t)StorageSim::resetReason(); }
+
+typedef void (*shutdown_handler_t)(void);
+
+struct StorageSimShutdown {
+    inline static std::vector<shutdown_handler_t> handlers;
+};
+
+inline esp_err_t esp_register_shutdown_handler(shutdown_handler_t handler) {
+    for (shutdown_handler_t h : StorageSimShutdown::handlers) {
+        if (h == handler) return ESP_FAIL;  // как в IDF: ESP_ERR_INVALID_STATE
+    }
+    StorageSimShutdown::handlers.push_back(handler);
+    return ESP_OK;
+}
+
+inline esp_err_t esp_unregister_shutdown_handler(shutdown_handler_t handler) {
+    auto& v = StorageSimShutdown::handlers;
+    for (auto it = v.begin(); it != v.end(); ++it) {
+        if (*it == handler) {
+            v.erase(it);
+            return ESP_OK;
+        }
+    }
+    return ESP_FAIL;
+}
+
+// Обработчики выключения вызываются в обратном порядке регистрации, затем "перезагрузка":
+// программа продолжает работу, esp_reset_reason() = ESP_RST_SW
+inline void esp_restart() {
+    auto& v = StorageSimShutdown::handlers;
+    for (auto it = v.rbegin(); it != v.rend(); ++it) (*it)();
+    StorageSim::powerCycle(ESP_RST_SW);
+}
+
+#endif
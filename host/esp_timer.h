@@ -0,0 +1,9 @@
+#ifndef BSY_UNISTOR_HOST_ESP_TIMER_H
+#define BSY_UNISTOR_HOST_ESP_TIMER_H
+
+#include "BSY_UNISTOR_host_sim.h"
+
+// Часы симулятора, мкс
+inline int64_t esp_timer_get_time() { return (int64_t)StorageSim::micros(); }
+
+#endif
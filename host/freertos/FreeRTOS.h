@@ -0,0 +1,70 @@
+#ifndef BSY_UNISTOR_HOST_FREERTOS_H
+#define BSY_UNISTOR_HOST_FREERTOS_H
+
+// Хост-бэкенд: задачи - std::thread, очереди и мьютексы - std, тики - часы StorageSim
+
+#include "../BSY_UNISTOR_host_sim.h"
+#include <condition_variable>
+#include <deque>
+
+typedef int BaseType_t;
+typedef unsigned UBaseType_t;
+typedef uint32_t TickType_t;
+typedef void* TaskHandle_t;
+typedef void (*TaskFunction_t)(void*);
+
+#define pdTRUE  1
+#define pdFALSE 0
+#define pdPASS  1
+#define portMAX_DELAY 0xFFFFFFFFu
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(x) (x)
+#define tskNO_AFFINITY 0x7FFFFFFF
+#define configMAX_PRIORITIES 25
+
+struct portMUX_TYPE {
+    std::recursive_mutex m;
+};
+#define portMUX_INITIALIZER_UNLOCKED {}
+#define portENTER_CRITICAL(mux) (mux)->m.lock()
+#define portEXIT_CRITICAL(mux) (mux)->m.unlock()
+
+inline TickType_t xTaskGetTickCount() { return StorageSim::millis(); }
+
+// Часы симулятора идут вперед, а задача уступает процессор остальным потокам
+inline void vTaskDelay(TickType_t ticks) {
+    StorageSim::advance(ticks);
+    std::this_thread::sleep_for(std::chrono::microseconds(ticks ? 200 : 0));
+}
+
+inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char*, uint32_t, void* arg,
+                                          UBaseType_t, TaskHandle_t* handle, BaseType_t) {
+    std::thread* t = new std::thread(fn, arg);
+    t->detach();
+    if (handle) *handle = t;
+    return pdPASS;
+}
+
+inline void vTaskDelete(TaskHandle_t) {}
+
+/**
+ * Очередь и семафоры FreeRTOS
+ */
+struct StorageSimQueue {
+    std::mutex m;
+    std::condition_variable cv;
+    std::deque<std::vector<uint8_t>> items;
+    size_t itemSize = 0;
+    size_t capacity = 0;
+    bool isMutex = false;
+    std::timed_mutex mutex;
+    std::recursive_timed_mutex recursive;
+};
+typedef StorageSimQueue* QueueHandle_t;
+typedef StorageSimQueue* SemaphoreHandle_t;
+
+inline std::chrono::milliseconds storageSimWait(TickType_t ticks) {
+    return std::chrono::milliseconds(ticks == portMAX_DELAY ? 24 * 3600 * 1000 : ticks);
+}
+
+#endif
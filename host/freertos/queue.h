@@ -0,0 +1,37 @@
+#ifndef BSY_UNISTOR_HOST_QUEUE_H
+#define BSY_UNISTOR_HOST_QUEUE_H
+
+#include "FreeRTOS.h"
+
+inline QueueHandle_t xQueueCreate(size_t length, size_t itemSize) {
+    StorageSimQueue* q = new StorageSimQueue;
+    q->itemSize = itemSize;
+    q->capacity = length;
+    return q;
+}
+
+inline BaseType_t xQueueSend(QueueHandle_t q, const void* item, TickType_t ticks) {
+    std::unique_lock<std::mutex> lock(q->m);
+    if (!q->cv.wait_for(lock, storageSimWait(ticks), [&] { return q->items.size() < q->capacity; })) return pdFALSE;
+    const uint8_t* p = (const uint8_t*)item;
+    q->items.emplace_back(p, p + q->itemSize);
+    q->cv.notify_all();
+    return pdTRUE;
+}
+#define xQueueSendToBack xQueueSend
+
+inline BaseType_t xQueueReceive(QueueHandle_t q, void* item, TickType_t ticks) {
+    std::unique_lock<std::mutex> lock(q->m);
+    if (!q->cv.wait_for(lock, storageSimWait(ticks), [&] { return !q->items.empty(); })) return pdFALSE;
+    if (q->itemSize) memcpy(item, q->items.front().data(), q->itemSize);
+    q->items.pop_front();
+    q->cv.notify_all();
+    return pdTRUE;
+}
+
+inline UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q) {
+    std::lock_guard<std::mutex> lock(q->m);
+    return (UBaseType_t)q->items.size();
+}
+
+#endif
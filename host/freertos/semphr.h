@@ -0,0 +1,38 @@
+#ifndef BSY_UNISTOR_HOST_SEMPHR_H
+#define BSY_UNISTOR_HOST_SEMPHR_H
+
+#include "queue.h"
+
+inline SemaphoreHandle_t xSemaphoreCreateMutex() {
+    StorageSimQueue* s = new StorageSimQueue;
+    s->isMutex = true;
+    return s;
+}
+
+inline SemaphoreHandle_t xSemaphoreCreateRecursiveMutex() { return xSemaphoreCreateMutex(); }
+
+inline SemaphoreHandle_t xSemaphoreCreateBinary() { return xQueueCreate(1, 0); }
+
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t s, TickType_t ticks) {
+    if (s->isMutex) return s->mutex.try_lock_for(storageSimWait(ticks)) ? pdTRUE : pdFALSE;
+    return xQueueReceive(s, nullptr, ticks);
+}
+
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t s) {
+    if (s->isMutex) {
+        s->mutex.unlock();
+        return pdTRUE;
+    }
+    return xQueueSend(s, nullptr, 0);
+}
+
+inline BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t s, TickType_t ticks) {
+    return s->recursive.try_lock_for(storageSimWait(ticks)) ? pdTRUE : pdFALSE;
+}
+
+inline BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t s) {
+    s->recursive.unlock();
+    return pdTRUE;
+}
+
+#endif
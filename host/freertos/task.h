@@ -0,0 +1,4 @@
+#ifndef BSY_UNISTOR_HOST_TASK_H
+#define BSY_UNISTOR_HOST_TASK_H
+#include "FreeRTOS.h"
+#endif
@@ -0,0 +1,124 @@
+#ifndef BSY_UNISTOR_HOST_NVS_H
+#define BSY_UNISTOR_HOST_NVS_H
+
+// Хост-бэкенд: C API NVS поверх StorageSim::nvs (том же, что у Preferences).
+// Как в ESP-IDF, nvs_set_* пишет ключ сразу и атомарно, nvs_commit() только фиксирует сессию
+
+#include "esp_system.h"
+
+#define ESP_ERR_NVS_NOT_FOUND 0x1102
+#define ESP_ERR_NVS_INVALID_HANDLE 0x1107
+#define ESP_ERR_NVS_INVALID_NAME 0x1108
+#define ESP_ERR_NVS_INVALID_LENGTH 0x110c
+
+typedef uint32_t nvs_handle_t;
+
+typedef enum { NVS_READONLY, NVS_READWRITE } nvs_open_mode_t;
+
+struct StorageSimNvsHandles {
+    struct Handle {
+        std::string ns;
+        bool readWrite;
+    };
+    inline static std::map<nvs_handle_t, Handle> open;
+    inline static nvs_handle_t next = 1;
+
+    static Handle* find(nvs_handle_t h) {
+        auto it = open.find(h);
+        return it == open.end() ? nullptr : &it->second;
+    }
+
+    // Типы записей совпадают с PreferenceType: PT_I8 = 0 ... PT_U64 = 7, PT_BLOB = 9
+    static esp_err_t set(nvs_handle_t h, const char* key, const void* value, size_t len, uint8_t type) {
+        std::lock_guard<std::recursive_mutex> g(StorageSim::mutex());
+        Handle* hd = find(h);
+        if (!hd || !hd->readWrite) return ESP_ERR_NVS_INVALID_HANDLE;
+        if (!key || !*key || strlen(key) > 15) return ESP_ERR_NVS_INVALID_NAME;
+        StorageSim::busy(StorageSim::latency().nvsWriteUs);
+        if (StorageSim::spend(len) != len) return ESP_FAIL;  // питание пропало - ключ не изменился
+        const uint8_t* p = (const uint8_t*)value;
+        StorageSim::nvs[hd->ns][key] = StorageSim::NvsEntry{ type, std::vector<uint8_t>(p, p + len) };
+        StorageSim::stats().nvsWrites++;
+        StorageSim::stats().nvsBytes += len;
+        return ESP_OK;
+    }
+};
+
+inline esp_err_t nvs_open(const char* name, nvs_open_mode_t mode, nvs_handle_t* out) {
+    if (!name || strlen(name) > 15) return ESP_ERR_NVS_INVALID_NAME;
+    std::lock_guard<std::recursive_mutex> g(StorageSim::mutex());
+    if (mode == NVS_READONLY && !StorageSim::nvs.count(name)) return ESP_ERR_NVS_NOT_FOUND;
+    if (mode == NVS_READWRITE) {
+        if (!StorageSim::powered()) return ESP_FAIL;
+        StorageSim::nvs[name];
+    }
+    nvs_handle_t h = StorageSimNvsHandles::next++;
+    StorageSimNvsHandles::open[h] = { name, mode == NVS_READWRITE };
+    *out = h;
+    return ESP_OK;
+}
+
+inline void nvs_close(nvs_handle_t h) {
+    std::lock_guard<std::recursive_mutex> g(StorageSim::mutex());
+    StorageSimNvsHandles::open.erase(h);
+}
+
+inline esp_err_t nvs_commit(nvs_handle_t h) {
+    std::lock_guard<std::recursive_mutex> g(StorageSim::mutex());
+    StorageSimNvsHandles::Handle* hd = StorageSimNvsHandles::find(h);
+    if (!hd || !hd->readWrite) return ESP_ERR_NVS_INVALID_HANDLE;
+    if (!StorageSim::powered()) return ESP_FAIL;
+    StorageSim::stats().nvsCommits++;
+    return ESP_OK;
+}
+
+inline esp_err_t nvs_set_blob(nvs_handle_t h, const char* key, const void* value, size_t len) {
+    return StorageSimNvsHandles::set(h, key, value, len, 9);
+}
+inline esp_err_t nvs_set_i8(nvs_handle_t h, const char* key, int8_t v) { return StorageSimNvsHandles::set(h, key, &v, 1, 0); }
+inline esp_err_t nvs_set_u8(nvs_handle_t h, const char* key, uint8_t v) { return StorageSimNvsHandles::set(h, key, &v, 1, 1); }
+inline esp_err_t nvs_set_i16(nvs_handle_t h, const char* key, int16_t v) { return StorageSimNvsHandles::set(h, key, &v, 2, 2); }
+inline esp_err_t nvs_set_u16(nvs_handle_t h, const char* key, uint16_t v) { return StorageSimNvsHandles::set(h, key, &v, 2, 3); }
+inline esp_err_t nvs_set_i32(nvs_handle_t h, const char* key, int32_t v) { return StorageSimNvsHandles::set(h, key, &v, 4, 4); }
+inline esp_err_t nvs_set_u32(nvs_handle_t h, const char* key, uint32_t v) { return StorageSimNvsHandles::set(h, key, &v, 4, 5); }
+inline esp_err_t nvs_set_i64(nvs_handle_t h, const char* key, int64_t v) { return StorageSimNvsHandles::set(h, key, &v, 8, 6); }
+inline esp_err_t nvs_set_u64(nvs_handle_t h, const char* key, uint64_t v) { return StorageSimNvsHandles::set(h, key, &v, 8, 7); }
+
+// Как в ESP-IDF: буфер меньше значения - ESP_ERR_NVS_INVALID_LENGTH, по частям не читается
+inline esp_err_t nvs_get_blob(nvs_handle_t h, const char* key, void* out, size_t* len) {
+    std::lock_guard<std::recursive_mutex> g(StorageSim::mutex());
+    StorageSimNvsHandles::Handle* hd = StorageSimNvsHandles::find(h);
+    if (!hd) return ESP_ERR_NVS_INVALID_HANDLE;
+    auto n = StorageSim::nvs.find(hd->ns);
+    if (n == StorageSim::nvs.end() || !n->second.count(key)) return ESP_ERR_NVS_NOT_FOUND;
+    const std::vector<uint8_t>& v = n->second[key].data;
+    if (!out) {
+        *len = v.size();
+        return ESP_OK;
+    }
+    if (*len < v.size()) return ESP_ERR_NVS_INVALID_LENGTH;
+    StorageSim::busy(StorageSim::latency().nvsReadUs);
+    StorageSim::stats().nvsReads++;
+    memcpy(out, v.data(), v.size());
+    *len = v.size();
+    return ESP_OK;
+}
+
+inline esp_err_t nvs_erase_key(nvs_handle_t h, const char* key) {
+    std::lock_guard<std::recursive_mutex> g(StorageSim::mutex());
+    StorageSimNvsHandles::Handle* hd = StorageSimNvsHandles::find(h);
+    if (!hd || !hd->readWrite) return ESP_ERR_NVS_INVALID_HANDLE;
+    if (!StorageSim::powered()) return ESP_FAIL;
+    return StorageSim::nvs[hd->ns].erase(key) ? ESP_OK : ESP_ERR_NVS_NOT_FOUND;
+}
+
+inline esp_err_t nvs_erase_all(nvs_handle_t h) {
+    std::lock_guard<std::recursive_mutex> g(StorageSim::mutex());
+    StorageSimNvsHandles::Handle* hd = StorageSimNvsHandles::find(h);
+    if (!hd || !hd->readWrite) return ESP_ERR_NVS_INVALID_HANDLE;
+    if (!StorageSim::powered()) return ESP_FAIL;
+    StorageSim::nvs[hd->ns].clear();
+    return ESP_OK;
+}
+
+#endif
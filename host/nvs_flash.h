@@ -0,0 +1,15 @@
+#ifndef BSY_UNISTOR_HOST_NVS_FLASH_H
+#define BSY_UNISTOR_HOST_NVS_FLASH_H
+
+#include "nvs.h"
+
+inline esp_err_t nvs_flash_init() { return ESP_OK; }
+
+inline esp_err_t nvs_flash_erase() {
+    if (!StorageSim::powered()) return ESP_FAIL;
+    std::lock_guard<std::recursive_mutex> g(StorageSim::mutex());
+    StorageSim::nvs.clear();
+    return ESP_OK;
+}
+
+#endif
@@ -0,0 +1,102 @@
+#ifndef BSY_UNISTOR_HOST_TEST_H
+#define BSY_UNISTOR_HOST_TEST_H
+
+/**
+ * Минимальный каркас тестов на хост-бэкенде: HOST_TEST регистрирует тест,
+ * CHECK считает ошибки и не прерывает тест. Каждый тест начинается с hostReset()
+ */
+
+#include "BSY_ESP32_UniversalStorages.h"
+
+struct HostTest {
+    const char* name;
+    void (*fn)();
+    HostTest* next;
+
+    inline static HostTest* head = nullptr;
+    inline static HostTest* tail = nullptr;
+    inline static int failures = 0;
+
+    HostTest(const char* n, void (*f)()) : name(n), fn(f), next(nullptr) {
+        if (tail) tail->next = this; else head = this;
+        tail = this;
+    }
+
+    static void fail(const char* file, int line, const char* expr) {
+        failures++;
+        fprintf(stderr, "  FAIL %s:%d: %s\n", file, line, expr);
+    }
+};
+
+#define HOST_TEST(name) \
+    static void name(); \
+    static HostTest name##_reg(#name, name); \
+    static void name()
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) HostTest::fail(__FILE__, __LINE__, #cond); \
+    } while (0)
+
+/**
+ * Перезагрузка: питание включено, RAM-состояние загрузки (StorageRtcSession) сброшено.
+ * Объекты хранилищ тест создает заново
+ * @param resetReason Причина сброса (ESP_RST_POWERON, ESP_RST_DEEPSLEEP, ...)
+ */
+inline void hostReboot(int resetReason = ESP_RST_POWERON) {
+    StorageSim::powerCycle(resetReason);
+    StorageRtcSession::restart();
+    StorageManager::refreshStats();
+}
+
+/**
+ * Чистый "флеш", питание включено, LittleFS смонтирована, кэш статистики пересчитан
+ */
+inline void hostReset() {
+    StorageSim::reset();
+    StorageRtcSession::restart();
+    StorageFS::begin();
+}
+
+/**
+ * Содержимое флеша (NVS и файлы) для возврата к исходному состоянию между итерациями
+ */
+struct HostFlash {
+    std::map<std::string, std::map<std::string, StorageSim::NvsEntry>> nvs;
+    std::map<std::string, std::vector<uint8_t>> files;
+
+    static HostFlash take() { return HostFlash{ StorageSim::nvs, StorageSim::files }; }
+
+    void restore() const {
+        StorageSim::nvs = nvs;
+        StorageSim::files = files;
+        StorageManager::refreshStats();
+    }
+};
+
+/**
+ * Перебор точек отказа питания: write() выполняется с отключением питания
+ * после 0, 1, 2, ... байт записи, пока не пройдет целиком. Перед каждой попыткой
+ * флеш возвращается в состояние на момент вызова, после неё - "включение" и check()
+ * @param write Запись (создает свои объекты хранилищ)
+ * @param check Проверка после перезагрузки (создает объекты заново)
+ * @param arm Как ставить отказ (StorageSim::cutPowerAfterOps - по переименованиям и удалениям)
+ * @return Сколько точек отказа проверено
+ */
+template <typename Write, typename Check>
+size_t powerLossSweep(Write write, Check check, void (*arm)(size_t) = StorageSim::cutPowerAfter) {
+    HostFlash before = HostFlash::take();
+    size_t cut = 0;
+    for (;; cut++) {
+        before.restore();
+        arm(cut);
+        write();
+        bool finished = StorageSim::powered();
+        hostReboot();
+        check(finished);
+        if (finished) break;
+    }
+    return cut;
+}
+
+#endif
@@ -0,0 +1,340 @@
+// StorageBigAkaFileSys: сбой питания во время save() (обычный файл, RLE, блочный режим), порча файла
+
+#include "host_test.h"
+
+namespace {
+
+struct Big {
+    uint8_t d[3000];
+};
+
+Big noisy(uint8_t seed) {
+    Big v;
+    for (size_t i = 0; i < sizeof(v.d); i++) v.d[i] = (uint8_t)(seed + i * 13 + (i >> 5));
+    return v;
+}
+
+// Длинные серии - RLE сжимает
+Big runs(uint8_t seed) {
+    Big v;
+    for (size_t i = 0; i < sizeof(v.d); i++) v.d[i] = (uint8_t)(seed + i / 100);
+    return v;
+}
+
+bool same(const Big& a, const Big& b) {
+    return memcmp(&a, &b, sizeof(Big)) == 0;
+}
+
+Big resetValue() {
+    Big v;
+    memset(&v, 0xA5, sizeof(v));
+    return v;
+}
+
+void resetBig(Big& v) {
+    v = resetValue();
+}
+
+// save() с отключением питания в любой момент: load() после включения
+// возвращает либо прежний объект, либо новый целиком
+template <typename Fs>
+void sweepSave(StorageSim::PowerLoss mode, const Big& oldV, const Big& newV) {
+    hostReset();
+    StorageSim::setPowerLossMode(mode);
+    {
+        Big data = oldV;
+        Fs fs("/big.bin", data, 0);
+        CHECK(fs.save());
+    }
+    powerLossSweep([&] {
+        Big data = newV;
+        Fs fs("/big.bin", data, 0);
+        fs.save();
+    }, [&](bool finished) {
+        Big out;
+        Fs fs("/big.bin", out, 0);
+        CHECK(fs.load(resetBig));
+        CHECK(same(out, oldV) || same(out, newV));
+        if (finished) CHECK(same(out, newV));
+    });
+}
+
+typedef StorageBigAkaFileSys<Big> PlainFs;
+typedef StorageBigAkaFileSys<Big, StorageCrc32, StorageDefaultLock, StorageRleCodec> RleFs;
+
+// Блочный режим: новое значение отличается от старого в блоках 1 и 4 из 7
+Big deltaOf(const Big& v) {
+    Big out = v;
+    memset(out.d + 600, 0x11, 100);
+    memset(out.d + 2100, 0x22, 300);
+    return out;
+}
+
+// Блочный save() с отключением питания в любой момент: load() возвращает прежний
+// объект или новый целиком, а не смесь блоков
+void sweepDelta(StorageSim::PowerLoss mode, void (*arm)(size_t)) {
+    hostReset();
+    StorageSim::setPowerLossMode(mode);
+    const Big oldV = noisy(1);
+    const Big newV = deltaOf(oldV);
+    {
+        Big data = oldV;
+        PlainFs fs("/big.bin", data, 0);
+        fs.setDeltaSave(true);
+        CHECK(fs.save());
+    }
+    size_t cuts = powerLossSweep([&] {
+        Big data;
+        PlainFs fs("/big.bin", data, 0);
+        fs.setDeltaSave(true);
+        fs.load(resetBig);
+        Big next = deltaOf(data);
+        memcpy(data.d + 600, next.d + 600, 100);
+        fs.update(600, 100);
+        memcpy(data.d + 2100, next.d + 2100, 300);
+        fs.update(2100, 300);
+        fs.save();
+    }, [&](bool finished) {
+        Big out;
+        PlainFs fs("/big.bin", out, 0);
+        fs.setDeltaSave(true);
+        CHECK(fs.load(resetBig));
+        CHECK(same(out, oldV) || same(out, newV));
+        if (finished) CHECK(same(out, newV));
+
+        // После восстановления следующая блочная запись ложится как обычно
+        out.d[10] ^= 0xFF;
+        fs.update(10, 1);
+        CHECK(fs.save());
+        Big again;
+        PlainFs fs2("/big.bin", again, 0);
+        fs2.setDeltaSave(true);
+        CHECK(fs2.load(resetBig));
+        CHECK(same(again, out));
+    }, arm);
+    CHECK(cuts > 0);
+}
+
+}  // namespace
+
+HOST_TEST(fs_power_loss_torn) {
+    sweepSave<PlainFs>(StorageSim::TORN, noisy(1), noisy(2));
+}
+
+HOST_TEST(fs_power_loss_commit) {
+    sweepSave<PlainFs>(StorageSim::COMMIT, noisy(1), noisy(2));
+}
+
+HOST_TEST(fs_power_loss_rle) {
+    sweepSave<RleFs>(StorageSim::TORN, runs(1), runs(2));
+    // RLE действительно включилось: файл меньше объекта
+    CHECK(StorageSim::files["/big.bin"].size() < sizeof(Big));
+}
+
+// Испорченный байт или обрезанный файл: load() возвращает false и применяет resetFunc
+HOST_TEST(fs_corrupt_detected) {
+    hostReset();
+    {
+        Big data = noisy(3);
+        PlainFs fs("/big.bin", data, 0);
+        CHECK(fs.save());
+    }
+    HostFlash clean = HostFlash::take();
+    size_t size = clean.files.at("/big.bin").size();
+    for (size_t off = 0; off < size; off += (off < 64 ? 1 : 97)) {
+        clean.restore();
+        CHECK(StorageSim::corrupt("/big.bin", off));
+        Big out;
+        PlainFs fs("/big.bin", out, 0);
+        CHECK(!fs.load(resetBig));
+        CHECK(same(out, resetValue()));
+    }
+    for (size_t len : { (size_t)0, (size_t)3, (size_t)16, size / 2, size - 1 }) {
+        clean.restore();
+        CHECK(StorageSim::truncate("/big.bin", len));
+        Big out;
+        PlainFs fs("/big.bin", out, 0);
+        CHECK(!fs.load(resetBig));
+        CHECK(same(out, resetValue()));
+    }
+}
+
+HOST_TEST(fs_delta_power_loss_torn) {
+    sweepDelta(StorageSim::TORN, StorageSim::cutPowerAfter);
+}
+
+HOST_TEST(fs_delta_power_loss_commit) {
+    sweepDelta(StorageSim::COMMIT, StorageSim::cutPowerAfter);
+}
+
+// Отказ между rename файлов блоков после записи фиксации
+HOST_TEST(fs_delta_power_loss_rename) {
+    sweepDelta(StorageSim::COMMIT, StorageSim::cutPowerAfterOps);
+}
+
+// Блочный режим пишет только файлы задетых блоков (и запись фиксации, если их несколько),
+// испорченный блок не принимается, файл обычного формата переводится в блоки
+HOST_TEST(fs_delta_blocks) {
+    static_assert(STORAGE_FS_DELTA_BLOCK == 496, "offsets below assume 7 blocks of 496");
+    const size_t blockFile = sizeof(StorageFileHeader) + STORAGE_FS_DELTA_BLOCK;
+    hostReset();
+    Big data = noisy(4);
+    {
+        PlainFs fs("/big.bin", data, 0);
+        fs.setDeltaSave(true);
+        CHECK(fs.save());
+        CHECK(fs.exists());
+        CHECK(!LittleFS.exists("/big.bin"));
+
+        // Один блок: только его файл, через .tmp и rename
+        StorageSim::resetStats();
+        data.d[1000] ^= 0xFF;
+        fs.update(1000, 1);
+        CHECK(fs.save());
+        CHECK(StorageSim::stats().fsBytes == blockFile);
+        CHECK(StorageSim::stats().fsFlashBytes == blockFile);
+
+        // Два блока: два файла и запись фиксации, она удаляется после rename
+        StorageSim::resetStats();
+        data.d[600] ^= 0xFF;
+        fs.update(600, 1);
+        data.d[2990] ^= 0xFF;
+        fs.update(2990, 1);
+        CHECK(fs.save());
+        size_t expected = blockFile + sizeof(StorageFileHeader) + (sizeof(Big) - 6 * STORAGE_FS_DELTA_BLOCK)
+            + sizeof(StorageDeltaCommit) + 2 * sizeof(uint16_t);
+        CHECK(StorageSim::stats().fsBytes == expected);
+        CHECK(StorageSim::stats().fsFlashBytes == expected);
+        CHECK(!LittleFS.exists("/big.bin.commit"));
+        CHECK(!LittleFS.exists("/big.bin.1.tmp"));
+
+        // Для сравнения: обычный файл переписывается целиком
+        StorageSim::resetStats();
+        PlainFs plain("/plain.bin", data, 0);
+        CHECK(plain.save());
+        CHECK(StorageSim::stats().fsFlashBytes >= sizeof(Big));
+        CHECK(plain.remove());
+    }
+
+    HostFlash clean = HostFlash::take();
+    for (size_t i = 0; i < 7; i++) {
+        String path = String("/big.bin.") + String((unsigned)i);
+        for (size_t off : { (size_t)4, sizeof(StorageFileHeader) + 3 }) {
+            clean.restore();
+            CHECK(StorageSim::corrupt(path.c_str(), off));
+            Big out;
+            PlainFs fs("/big.bin", out, 0);
+            fs.setDeltaSave(true);
+            CHECK(!fs.load(resetBig));
+            CHECK(same(out, resetValue()));
+        }
+    }
+    {
+        clean.restore();
+        Big out;
+        PlainFs fs("/big.bin", out, 0);
+        fs.setDeltaSave(true);
+        CHECK(fs.load(resetBig));
+        CHECK(same(out, data));
+        CHECK(fs.remove());
+        CHECK(!fs.exists());
+        CHECK(!LittleFS.exists("/big.bin.0") && !LittleFS.exists("/big.bin.6"));
+    }
+
+    // Файл обычного формата: читается, после первой записи блоков удаляется
+    hostReset();
+    {
+        PlainFs fs("/big.bin", data, 0);
+        CHECK(fs.save());
+    }
+    {
+        Big out;
+        PlainFs fs("/big.bin", out, 0);
+        fs.setDeltaSave(true);
+        CHECK(fs.load(resetBig));
+        CHECK(same(out, data));
+        CHECK(fs.save());
+        CHECK(!LittleFS.exists("/big.bin"));
+        CHECK(LittleFS.exists("/big.bin.6"));
+    }
+    Big out;
+    PlainFs fs("/big.bin", out, 0);
+    fs.setDeltaSave(true);
+    CHECK(fs.load(resetBig));
+    CHECK(same(out, data));
+}
+
+// Размер своего файла объект помнит: save() и remove() не обращаются к LittleFS
+// за размером, а кэш статистики сходится с файловой системой
+HOST_TEST(fs_size_tracking) {
+    hostReset();
+    auto usedMatches = [] {
+        size_t total, used;
+        StorageManager::fsStats(total, used);
+        return used == LittleFS.usedBytes();
+    };
+    Big data = noisy(5);
+    PlainFs fs("/big.bin", data, 0);
+    fs.setAtomicSave(false);
+    CHECK(fs.save());
+    CHECK(usedMatches());
+    StorageSim::resetStats();
+    data = runs(1);
+    CHECK(fs.save());
+    CHECK(StorageSim::stats().fsOpens == 1);  // только сама запись
+    CHECK(usedMatches());
+
+    StorageSim::resetStats();
+    CHECK(fs.remove());
+    CHECK(StorageSim::stats().fsOpens == 1);  // только сам remove
+    CHECK(usedMatches());
+
+    // Размер известен и после load()
+    CHECK(fs.save());
+    PlainFs again("/big.bin", data, 0);
+    again.setAtomicSave(false);
+    CHECK(again.load(resetBig));
+    StorageSim::resetStats();
+    CHECK(again.save());
+    CHECK(StorageSim::stats().fsOpens == 1);
+    CHECK(usedMatches());
+}
+
+// Без resetFunc испорченный файл не меняет данные: чтение идет через временный буфер,
+// а объект больше STORAGE_FS_STAGED_LOAD_MAX (читается прямо в данные) обнуляется
+HOST_TEST(fs_staged_load) {
+    hostReset();
+    const Big saved = noisy(6), current = noisy(7);
+    for (bool delta : { false, true }) {
+        {
+            Big data = saved;
+            PlainFs fs("/big.bin", data, 0);
+            fs.setDeltaSave(delta);
+            CHECK(fs.save());
+        }
+        // В блочном режиме - последний блок
+        CHECK(StorageSim::corrupt(delta ? "/big.bin.6" : "/big.bin", delta ? 20 : sizeof(Big) - 10));
+        Big data = current;
+        PlainFs fs("/big.bin", data, 0);
+        fs.setDeltaSave(delta);
+        CHECK(!fs.load());
+        CHECK(same(data, current));
+    }
+
+    struct Huge {
+        uint8_t d[STORAGE_FS_STAGED_LOAD_MAX + 100];
+    };
+    static Huge huge;
+    memset(&huge, 0x5A, sizeof(huge));
+    {
+        StorageBigAkaFileSys<Huge> fs("/huge.bin", huge, 0);
+        CHECK(fs.save());
+    }
+    CHECK(StorageSim::corrupt("/huge.bin", sizeof(Huge) - 10));
+    memset(&huge, 0x33, sizeof(huge));
+    StorageBigAkaFileSys<Huge> fs("/huge.bin", huge, 0);
+    CHECK(!fs.load());
+    bool zero = true;
+    for (uint8_t b : huge.d) zero = zero && b == 0;
+    CHECK(zero);
+}
@@ -0,0 +1,21 @@
+// Тесты библиотеки на ПК (хост-бэкенд из host/): сбои питания, порча данных, восстановление.
+// Сборка и запуск:
+//   cmake -S host/test -B build && cmake --build build && ctest --test-dir build --output-on-failure
+// или без CMake:
+//   g++ -std=gnu++17 -Wno-format -D STORAGE_DEBUG_DISABLE -I host -I src host/test/*.cpp -lpthread
+
+#include "host_test.h"
+
+int main(int argc, char** argv) {
+    const char* only = argc > 1 ? argv[1] : nullptr;  // имя теста или его начало
+    int run = 0;
+    for (HostTest* t = HostTest::head; t; t = t->next) {
+        if (only && strncmp(t->name, only, strlen(only)) != 0) continue;
+        int before = HostTest::failures;
+        t->fn();
+        run++;
+        printf("%s %s\n", HostTest::failures == before ? "ok  " : "FAIL", t->name);
+    }
+    printf("%d tests, %d failed checks\n", run, HostTest::failures);
+    return HostTest::failures ? 1 : 0;
+}
@@ -0,0 +1,210 @@
+// StorageSmallAkaNVS: сбой питания во время save(), порча значения
+
+#include "host_test.h"
+
+namespace {
+
+struct Small {
+    uint32_t a;
+    uint16_t b[6];
+};
+
+struct Large {
+    uint8_t d[2000];  // больше NVS_STACK_PACKAGE_MAX - пакет собирается в общем буфере
+};
+
+template <typename T>
+T pattern(uint8_t seed) {
+    T v;
+    uint8_t* p = (uint8_t*)&v;
+    for (size_t i = 0; i < sizeof(T); i++) p[i] = (uint8_t)(seed + i * 7);
+    return v;
+}
+
+template <typename T>
+bool same(const T& a, const T& b) {
+    return memcmp(&a, &b, sizeof(T)) == 0;
+}
+
+// save() нового значения с отключением питания в любой момент: после включения
+// load() возвращает либо прежнее, либо новое значение целиком
+template <typename T>
+void sweepSave() {
+    hostReset();
+    const T oldV = pattern<T>(1), newV = pattern<T>(100);
+    {
+        StorageSmallAkaNVS nvs("test");
+        CHECK(nvs.save("obj", oldV, 1, true));
+    }
+    size_t points = powerLossSweep([&] {
+        StorageSmallAkaNVS nvs("test");
+        nvs.save("obj", newV, 1, true);
+    }, [&](bool finished) {
+        StorageSmallAkaNVS nvs("test");
+        T out;
+        CHECK(nvs.load("obj", out, 1));
+        CHECK(same(out, oldV) || same(out, newV));
+        if (finished) CHECK(same(out, newV));
+    });
+    CHECK(points > 0);
+}
+
+}  // namespace
+
+HOST_TEST(nvs_power_loss_small) {
+    sweepSave<Small>();
+}
+
+HOST_TEST(nvs_power_loss_large) {
+    sweepSave<Large>();
+}
+
+// Любой испорченный байт пакета (заголовок или данные) отвергается load()
+HOST_TEST(nvs_corrupt_detected) {
+    hostReset();
+    const Small v = pattern<Small>(5);
+    {
+        StorageSmallAkaNVS nvs("test");
+        CHECK(nvs.save("obj", v, 1, true));
+    }
+    HostFlash clean = HostFlash::take();
+    for (size_t off = 0; off < 8 + sizeof(Small); off++) {
+        if (off >= 1 && off < 4) continue;  // reserved - не проверяется
+        clean.restore();
+        CHECK(StorageSim::corruptNvs("test", "obj", off));
+        StorageSmallAkaNVS nvs("test");
+        Small out = pattern<Small>(9);
+        CHECK(!nvs.load("obj", out, 1));
+        CHECK(same(out, pattern<Small>(9)));  // при ошибке данные вызывающего не меняются
+    }
+}
+
+// setSizeTolerant: структура выросла - общий префикс из флеша, хвост по умолчанию,
+// и после flush() во флеше полная структура; из двух объектов разом общий буфер не портится
+HOST_TEST(nvs_size_tolerant_grow) {
+    struct Old { uint32_t a; uint8_t d[500]; };
+    struct New { uint32_t a; uint8_t d[500]; uint32_t extra; };
+    hostReset();
+    const Old oldV = pattern<Old>(3);
+    {
+        StorageSmallAkaNVS nvs("test");
+        CHECK(nvs.save("obj", oldV, 1, true));
+    }
+    {
+        StorageSmallAkaNVS nvs("test"), other("other");
+        CHECK(other.save("big", pattern<Large>(7), 1, true));
+        nvs.setSizeTolerant(true);
+        New v;
+        v.extra = 0x12345678;
+        CHECK(nvs.load("obj", v, 1));
+        CHECK(memcmp(&v, &oldV, sizeof(Old)) == 0);
+        CHECK(v.extra == 0x12345678);
+        Large big;
+        CHECK(other.load("big", big, 1));
+        CHECK(same(big, pattern<Large>(7)));
+        CHECK(nvs.flush());
+    }
+    {
+        StorageSmallAkaNVS nvs("test");
+        New v;
+        CHECK(nvs.load("obj", v, 1));
+        CHECK(memcmp(&v, &oldV, sizeof(Old)) == 0);
+        CHECK(v.extra == 0x12345678);
+    }
+}
+
+// Отложенные записи лежат в статическом пуле (NVS_PENDING_SMALL + NVS_PENDING_LARGE буферов
+// на все объекты); когда пул занят, save() пишет сразу, и данные не теряются
+HOST_TEST(nvs_pending_pool) {
+    hostReset();
+    const char* keys[] = { "k0", "k1", "k2", "k3", "k4" };
+    {
+        StorageSmallAkaNVS a("a"), b("b");
+        StorageSmallAkaNVS* both[] = { &a, &b };
+        for (StorageSmallAkaNVS* nvs : both) {
+            for (const char* key : keys) CHECK(nvs->save(key, pattern<Small>(1), 1));
+        }
+        StorageSim::resetStats();
+        for (StorageSmallAkaNVS* nvs : both) {
+            for (const char* key : keys) CHECK(nvs->save(key, pattern<Small>(2), 1));
+        }
+        // 10 отложенных при 9 буферах: одна запись прошла сразу
+        CHECK(StorageSim::stats().nvsWrites == 10 - (NVS_PENDING_SMALL + NVS_PENDING_LARGE));
+        CHECK(a.hasPending() && b.hasPending());
+        Small out;
+        CHECK(b.load("k4", out, 1));
+        CHECK(same(out, pattern<Small>(2)));
+        CHECK(a.flush());
+        CHECK(b.flush());
+        CHECK(!a.hasPending() && !b.hasPending());
+    }
+    {
+        StorageSmallAkaNVS a("a"), b("b");
+        for (const char* key : keys) {
+            Small out;
+            CHECK(a.load(key, out, 1) && same(out, pattern<Small>(2)));
+            CHECK(b.load(key, out, 1) && same(out, pattern<Small>(2)));
+        }
+        // Буферы вернулись в пул: откладывать снова можно
+        CHECK(a.save("k0", pattern<Small>(3), 1, true));
+        CHECK(a.save("k0", pattern<Small>(4), 1));
+        CHECK(a.hasPending());
+    }
+}
+
+// Пакетная сессия: записи идут через один дескриптор и фиксируются одним коммитом,
+// endBatch() сообщает об отказе любой записи сессии
+HOST_TEST(nvs_batch_single_commit) {
+    hostReset();
+    const char* keys[] = { "k0", "k1", "k2", "k3", "k4" };
+    StorageSmallAkaNVS nvs("test");
+    StorageSim::resetStats();
+    for (const char* key : keys) CHECK(nvs.save(key, pattern<Small>(1), 1, true));
+    CHECK(nvs.saveValue("n", (int32_t)-5));
+    CHECK(StorageSim::stats().nvsCommits == 6);
+
+    StorageSim::resetStats();
+    {
+        StorageSmallAkaNVS::Batch batch(nvs);
+        CHECK(batch.ok());
+        for (const char* key : keys) CHECK(nvs.save(key, pattern<Small>(2), 1, true));
+        CHECK(nvs.saveValue("n", (int32_t)7));
+        CHECK(nvs.saveValue("f", 1.5f));
+        Small out;
+        CHECK(nvs.load("k3", out, 1) && same(out, pattern<Small>(2)));
+        CHECK(StorageSim::stats().nvsCommits == 0);
+        CHECK(batch.end());
+    }
+    CHECK(StorageSim::stats().nvsCommits == 1);
+    {
+        StorageSmallAkaNVS again("test");
+        Small out;
+        for (const char* key : keys) CHECK(again.load(key, out, 1) && same(out, pattern<Small>(2)));
+        int32_t n = 0;
+        float f = 0;
+        CHECK(again.loadValue("n", n) && n == 7);
+        CHECK(again.loadValue("f", f) && f == 1.5f);
+    }
+
+    // Питание пропало посреди сессии - endBatch() возвращает false
+    CHECK(nvs.beginBatch());
+    CHECK(nvs.save("k0", pattern<Small>(3), 1, true));
+    StorageSim::cutPowerAfter(0);
+    CHECK(!nvs.save("k1", pattern<Small>(3), 1, true));
+    CHECK(!nvs.endBatch());
+    CHECK(!nvs.endBatch());  // сессия уже закрыта
+}
+
+// Отложенное сохранение локального экземпляра записывается его деструктором
+HOST_TEST(nvs_pending_flushed_by_destructor) {
+    hostReset();
+    {
+        StorageSmallAkaNVS nvs("test");
+        CHECK(nvs.save("obj", pattern<Small>(1), 1, true));
+        CHECK(nvs.save("obj", pattern<Small>(2), 1));  // в пределах интервала - отложено
+        CHECK(nvs.hasPending());
+    }
+    StorageSmallAkaNVS nvs("test");
+    Small out;
+    CHECK(nvs.load("obj", out, 1) && same(out, pattern<Small>(2)));
+}
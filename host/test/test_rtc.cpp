@@ -0,0 +1,167 @@
+// StorageRtcShadow: запись во флеш раз в writeEvery сохранений с изменениями,
+// восстановление после deep sleep и после включения питания
+
+#include "host_test.h"
+
+namespace {
+
+struct Cfg {
+    uint32_t counter;
+    uint8_t pad[60];
+};
+
+struct Table {
+    uint32_t counter;
+    uint8_t pad[1500];
+};
+
+template <typename T>
+T value(uint32_t counter) {
+    T v;
+    memset(&v, 0, sizeof(v));
+    v.counter = counter;
+    return v;
+}
+
+StorageRtcShadow<Cfg> cfgShadow;      // на плате - RTC_NOINIT_ATTR
+StorageRtcShadow<Table> tableShadow;
+
+}  // namespace
+
+// Загрузка после включения питания: 25 сохранений разных данных с writeEvery = 10
+// пишут NVS дважды, одинаковые - ни разу; после пропадания питания во флеше 20-е значение
+HOST_TEST(rtc_nvs_poweron_write_every) {
+    hostReset();
+    memset(&cfgShadow, 0xCC, sizeof(cfgShadow));  // RTC-память после включения - мусор
+    {
+        StorageSmallAkaNVS nvs("test");
+        Cfg c = value<Cfg>(0);
+        CHECK(!nvs.load("cfg", c, 1, cfgShadow));  // во флеше ещё ничего нет
+
+        StorageSim::resetStats();
+        for (uint32_t i = 1; i <= 25; i++) {
+            c = value<Cfg>(i);
+            CHECK(nvs.save("cfg", c, 1, cfgShadow, 10));
+        }
+        CHECK(StorageSim::stats().nvsWrites == 2);
+
+        StorageSim::resetStats();
+        for (int i = 0; i < 15; i++) CHECK(nvs.save("cfg", c, 1, cfgShadow, 10));
+        CHECK(StorageSim::stats().nvsWrites == 0);  // без изменений - не в счет
+    }
+
+    hostReboot(ESP_RST_POWERON);  // RTC-копия не принимается
+    {
+        StorageSmallAkaNVS nvs("test");
+        Cfg c = value<Cfg>(0);
+        CHECK(nvs.load("cfg", c, 1, cfgShadow));
+        CHECK(c.counter == 20);
+
+        // Копия заполнена из флеша и действует до конца загрузки
+        StorageSim::resetStats();
+        for (uint32_t i = 21; i <= 30; i++) {
+            c = value<Cfg>(i);
+            CHECK(nvs.save("cfg", c, 1, cfgShadow, 10));
+        }
+        CHECK(StorageSim::stats().nvsWrites == 1);
+        c = value<Cfg>(31);
+        CHECK(nvs.save("cfg", c, 1, cfgShadow, 10));
+        Cfg again = value<Cfg>(0);
+        CHECK(nvs.load("cfg", again, 1, cfgShadow));  // повторная загрузка - из RTC
+        CHECK(again.counter == 31);
+    }
+}
+
+// Deep sleep: load() берет данные из RTC без чтения флеша, включая сохранения не во флеше
+HOST_TEST(rtc_nvs_deep_sleep) {
+    hostReset();
+    {
+        StorageSmallAkaNVS nvs("test");
+        Cfg c = value<Cfg>(1);
+        CHECK(nvs.save("cfg", c, 1, true));
+        CHECK(nvs.load("cfg", c, 1, cfgShadow));
+        c = value<Cfg>(2);
+        CHECK(nvs.save("cfg", c, 1, cfgShadow, 10));
+    }
+    hostReboot(ESP_RST_DEEPSLEEP);
+    StorageSim::resetStats();
+    {
+        StorageSmallAkaNVS nvs("test");
+        Cfg c = value<Cfg>(0);
+        CHECK(nvs.load("cfg", c, 1, cfgShadow));
+        CHECK(c.counter == 2);
+        CHECK(StorageSim::stats().nvsReads == 0);
+    }
+    hostReboot(ESP_RST_BROWNOUT);
+    {
+        StorageSmallAkaNVS nvs("test");
+        Cfg c = value<Cfg>(0);
+        CHECK(nvs.load("cfg", c, 1, cfgShadow));
+        CHECK(c.counter == 1);  // RTC-память после brownout не используется
+    }
+}
+
+// То же для StorageBigAkaFileSys::setRtcShadow()
+HOST_TEST(rtc_fs_poweron_write_every) {
+    hostReset();
+    memset(&tableShadow, 0xCC, sizeof(tableShadow));
+    {
+        Table t = value<Table>(0);
+        StorageBigAkaFileSys<Table> fs("/table.bin", t, 0);
+        CHECK(fs.save());
+    }
+    {
+        Table t = value<Table>(0);
+        StorageBigAkaFileSys<Table> fs("/table.bin", t, 0);
+        fs.setRtcShadow(&tableShadow, 10);
+        CHECK(fs.load());
+
+        uint32_t saves = 0;
+        for (uint32_t i = 1; i <= 25; i++) {
+            t = value<Table>(i);
+            uint32_t before = StorageSim::stats().fsOpens;
+            CHECK(fs.save());
+            if (StorageSim::stats().fsOpens != before) saves++;
+        }
+        CHECK(saves == 2);
+    }
+    hostReboot(ESP_RST_POWERON);
+    {
+        Table t = value<Table>(0);
+        StorageBigAkaFileSys<Table> fs("/table.bin", t, 0);
+        fs.setRtcShadow(&tableShadow, 10);
+        CHECK(fs.load());
+        CHECK(t.counter == 20);
+    }
+}
+
+// flushCritical() и flushAll() пишут во флеш и то, что осталось только в RTC-копии:
+// после brownout копии не верят, данные должны быть в файле
+HOST_TEST(rtc_fs_flush_critical_writes_through) {
+    for (bool critical : { true, false }) {
+        hostReset();
+        memset(&tableShadow, 0xCC, sizeof(tableShadow));
+        {
+            Table t = value<Table>(1);
+            StorageBigAkaFileSys<Table> fs("/table.bin", t, 0);
+            CHECK(fs.save());
+            fs.setRtcShadow(&tableShadow, 10);
+            CHECK(fs.load());
+            t = value<Table>(2);
+            uint32_t before = StorageSim::stats().fsOpens;
+            CHECK(fs.save());
+            CHECK(StorageSim::stats().fsOpens == before);  // пока только в RTC
+            CHECK(!fs.isDirty());
+            CHECK(critical ? StorageManager::flushCritical(1000) : StorageManager::flushAll());
+            CHECK(StorageSim::stats().fsOpens != before);
+        }
+        hostReboot(ESP_RST_BROWNOUT);
+        {
+            Table t = value<Table>(0);
+            StorageBigAkaFileSys<Table> fs("/table.bin", t, 0);
+            fs.setRtcShadow(&tableShadow, 10);
+            CHECK(fs.load());
+            CHECK(t.counter == 2);
+        }
+    }
+}
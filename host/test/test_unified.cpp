@@ -0,0 +1,59 @@
+// Storage<T>: edit() через ссылку пишется в tick() уже с изменением,
+// для бэкенда NVS и LittleFS, в том числе при дебаунсе 0
+
+#include "host_test.h"
+
+namespace {
+
+struct Settings {
+    uint32_t port;
+    uint8_t pad[28];
+};
+
+struct Table {
+    uint32_t port;
+    uint8_t pad[NVS_MAX_SIZE];  // не влезает в NVS - файл
+};
+
+static_assert(Storage<Settings>::IN_NVS, "Settings must go to NVS");
+static_assert(!Storage<Table>::IN_NVS, "Table must go to LittleFS");
+
+template <typename T>
+void resetCfg(T& v) {
+    memset(&v, 0, sizeof(v));
+    v.port = 80;
+}
+
+template <typename T>
+void checkEdit(uint32_t intervalSec) {
+    hostReset();
+    {
+        Storage<T> s("cfg", 1, intervalSec);
+        s.begin(resetCfg<T>);
+        CHECK(s->port == 80);
+        s.edit().port = 8080;
+        CHECK(s.isDirty());
+        if (intervalSec) {
+            s.tick();
+            CHECK(s.isDirty());  // дебаунс ещё не истек
+            delay(intervalSec * 1000);
+        }
+        s.tick();
+        CHECK(!s.isDirty());
+    }
+    Storage<T> again("cfg", 1, intervalSec);
+    CHECK(again.begin(resetCfg<T>));
+    CHECK(again->port == 8080);
+}
+
+}  // namespace
+
+HOST_TEST(unified_nvs_edit) {
+    checkEdit<Settings>(0);
+    checkEdit<Settings>(5);
+}
+
+HOST_TEST(unified_fs_edit) {
+    checkEdit<Table>(0);
+    checkEdit<Table>(5);
+}
@@ -30,34 +30,204 @@ build_flags =
 #define STORAGE_LOG_INFO    3
 #define STORAGE_LOG_DEBUG   4
 
+// Уровень журнала. Вызовы ST_LOG ниже уровня вырезаются при компиляции:
+// ни форматирования, ни строк формата в прошивке. -D STORAGE_DEBUG_DISABLE - без журнала совсем
 #ifndef STORAGE_LOG_LEVEL
 #define STORAGE_LOG_LEVEL STORAGE_LOG_INFO
 #endif
 
+#if !defined(STORAGE_DEBUG_DISABLE) && STORAGE_LOG_LEVEL > STORAGE_LOG_NONE
 #define STORAGE_DEBUG_ENABLE
+#endif
+
+// Куда идет журнал (StorageLog::setCallback() перехватывает любой вариант):
+// SERIAL - Serial, запись ждет UART; ESP_LOG - esp_log_write() с тегом "STORAGE";
+// RING - кольцевой буфер в RAM на STORAGE_LOG_RING_SIZE байт, вывод через StorageLog::drain(Serial)
+#define STORAGE_LOG_SINK_SERIAL  0
+#define STORAGE_LOG_SINK_ESP_LOG 1
+#define STORAGE_LOG_SINK_RING    2
+
+#ifndef STORAGE_LOG_SINK
+#define STORAGE_LOG_SINK STORAGE_LOG_SINK_SERIAL
+#endif
+#ifndef STORAGE_LOG_RING_SIZE
+#define STORAGE_LOG_RING_SIZE 2048
+#endif
+// Максимальная длина строки журнала (собирается в стеке, длинные обрезаются)
+#ifndef STORAGE_LOG_LINE_MAX
+#define STORAGE_LOG_LINE_MAX 160
+#endif
+
 #define STORAGE_CHECK_OTA
+// -D STORAGE_THREAD_SAFE - блокировки в NVS и в StorageBigAkaFileSys по умолчанию (работа из нескольких задач)
+// -D STORAGE_METRICS - счетчики загрузок/записей/байт/ошибок и время операций (StorageMetricsSource)
 #define NVS_MAX_SIZE 3000
 
+// Размер RAM-кэша CRC ключей NVS на один неймспейс (0 - отключить пропуск неизменных записей)
+#ifndef NVS_CRC_CACHE_SIZE
+#define NVS_CRC_CACHE_SIZE 16
+#endif
+
+// Сколько ключей одного неймспейса отслеживает защита от частых записей
+#ifndef NVS_THROTTLE_SLOTS
+#define NVS_THROTTLE_SLOTS 8
+#endif
+
+// Пакеты NVS не больше этого размера собираются в стеке, большие - в общем статическом буфере
+#ifndef NVS_STACK_PACKAGE_MAX
+#define NVS_STACK_PACKAGE_MAX 128
+#endif
+
+// Статический пул отложенных (задушенных) записей NVS, общий для всех неймспейсов:
+// буферы на NVS_STACK_PACKAGE_MAX байт и на NVS_MAX_SIZE байт. Когда пул занят - save() пишет сразу
+#ifndef NVS_PENDING_SMALL
+#define NVS_PENDING_SMALL 8
+#endif
+#ifndef NVS_PENDING_LARGE
+#define NVS_PENDING_LARGE 1
+#endif
+
+// Максимум полей в одной группе StorageSmallAkaNVS::Group
+#ifndef NVS_GROUP_MAX_FIELDS
+#define NVS_GROUP_MAX_FIELDS 16
+#endif
+
+// Максимум шагов в одной цепочке миграций StorageMigrations
+#ifndef STORAGE_MIGRATION_MAX
+#define STORAGE_MIGRATION_MAX 8
+#endif
+
+// Размер куска потокового чтения/записи файла (контрольная сумма считается по кускам)
+#ifndef STORAGE_FS_CHUNK_SIZE
+#define STORAGE_FS_CHUNK_SIZE 1024
+#endif
+
+// load() без setLoadBuffer() читает объекты до этого размера через временный буфер из кучи
+// (битый файл не испортит данные наполовину); больше - прямо в данные объекта
+#ifndef STORAGE_FS_STAGED_LOAD_MAX
+#define STORAGE_FS_STAGED_LOAD_MAX 16384
+#endif
+
+// Буфер копирования файлов StorageFS::copyFile (по умолчанию - размер блока LittleFS)
+#ifndef STORAGE_FS_COPY_BUFFER
+#define STORAGE_FS_COPY_BUFFER 4096
+#endif
+
+// Запись файлов через временный файл + rename: при сбое питания остаётся прежняя версия
+#ifndef STORAGE_FS_ATOMIC_SAVE
+#define STORAGE_FS_ATOMIC_SAVE 1
+#endif
+
+// Размер блока в блочном режиме StorageBigAkaFileSys::setDeltaSave(). Каждый блок -
+// отдельный файл с 16-байтным заголовком: до 512 байт вместе с ним (inline_max esp_littlefs)
+// файл хранится в метаданных LittleFS, больший занимает свой блок флеша (4 КБ)
+#ifndef STORAGE_FS_DELTA_BLOCK
+#define STORAGE_FS_DELTA_BLOCK 496
+#endif
+
+// Фоновая задача записи файлов (StorageWriter): ядро, приоритет, стек, длина очереди
+#ifndef STORAGE_WRITER_CORE
+#define STORAGE_WRITER_CORE 0
+#endif
+#ifndef STORAGE_WRITER_PRIORITY
+#define STORAGE_WRITER_PRIORITY 1
+#endif
+#ifndef STORAGE_WRITER_STACK
+#define STORAGE_WRITER_STACK 4096
+#endif
+#ifndef STORAGE_WRITER_QUEUE_LEN
+#define STORAGE_WRITER_QUEUE_LEN 16
+#endif
+
+// Планировщик StorageManager::tick(): файлы, срок которых наступит в пределах окна,
+// пишутся вместе с уже просроченными
+#ifndef STORAGE_FS_COALESCE_MS
+#define STORAGE_FS_COALESCE_MS 250
+#endif
+
+// Бюджет записи во флеш, байт/с (0 - без ограничения) и допустимый разовый всплеск
+#ifndef STORAGE_FS_BANDWIDTH
+#define STORAGE_FS_BANDWIDTH 0
+#endif
+#ifndef STORAGE_FS_BURST
+#define STORAGE_FS_BURST 8192
+#endif
+
+// Максимальная длина полного пути в StorageFS::forEachFile (буфер на стеке)
+#ifndef STORAGE_FS_PATH_MAX
+#define STORAGE_FS_PATH_MAX 128
+#endif
+
+// Кэш статистики LittleFS: размер блока для учета записей библиотеки и период
+// полного пересчета через usedBytes(), мс (0 - только по StorageFS::refreshStats())
+#ifndef STORAGE_FS_BLOCK
+#define STORAGE_FS_BLOCK 4096
+#endif
+#ifndef STORAGE_FS_STATS_MS
+#define STORAGE_FS_STATS_MS 60000
+#endif
+
+// RTC-копия (StorageRtcShadow): раз во сколько сохранений с изменениями писать во флеш
+#ifndef STORAGE_RTC_WRITE_EVERY
+#define STORAGE_RTC_WRITE_EVERY 10
+#endif
+
+// Неймспейс NVS по умолчанию для Storage<T>
+#ifndef STORAGE_UNIFIED_NAMESPACE
+#define STORAGE_UNIFIED_NAMESPACE "storage"
+#endif
+
+// Оценка времени записи файла, мкс на КБ, пока объект ни разу не писался
+// (дальше StorageManager::flushCritical() берет измеренное время)
+#ifndef STORAGE_FS_WRITE_US_PER_KB
+#define STORAGE_FS_WRITE_US_PER_KB 10000
+#endif
+
+// Бюджет записи при esp_restart() после StorageManager::flushOnShutdown(), мс
+#ifndef STORAGE_FS_SHUTDOWN_MS
+#define STORAGE_FS_SHUTDOWN_MS 300
+#endif
+
+// Сколько времени setOtaRunning(true) может потратить на запись изменений перед OTA, мс
+#ifndef STORAGE_OTA_FLUSH_MS
+#define STORAGE_OTA_FLUSH_MS 500
+#endif
+
 #ifdef STORAGE_DEBUG_ENABLE
-    #define ST_LOG(level, x, ...) \
-        if (level <= STORAGE_LOG_LEVEL) \
-            Serial.printf("[%lu][STORAGE][%s] " x "\n", millis(), \
-                         level == 1 ? "ERROR" : level == 2 ? "WARN" : \
-                         level == 3 ? "INFO" : "DEBUG", ##__VA_ARGS__)
+    #define ST_LOG_MAX_LEVEL STORAGE_LOG_LEVEL
 #else
-    #define ST_LOG(level, x, ...)
+    #define ST_LOG_MAX_LEVEL STORAGE_LOG_NONE
 #endif
 
+// Отброшенный вызов не компилируется в код, но его аргументы считаются использованными
+#define ST_LOG(level, x, ...) \
+    do { \
+        if constexpr ((level) <= ST_LOG_MAX_LEVEL) \
+            StorageLog::write(level, x, ##__VA_ARGS__); \
+    } while (0)
+
 extern "C" uint32_t crc32_le(uint32_t crc, unsigned char const *p, size_t len);
 
 
 // Подключаем модули
+#include "BSY_UNISTOR_0_log_part.h"
+#include "BSY_UNISTOR_0_checksum_part.h"
+#include "BSY_UNISTOR_0_lock_part.h"
+#include "BSY_UNISTOR_0_migrate_part.h"
+#include "BSY_UNISTOR_0_codec_part.h"
+#include "BSY_UNISTOR_0_rtc_part.h"
+#include "BSY_UNISTOR_0_metrics_part.h"
 #include "BSY_UNISTOR_a_NVS_part.h"
 
 #if BSY_STORAGE_USE_LITTLEFS
+    #include "BSY_UNISTOR_b_LITTLEFS_writer_part.h"
+    #include "BSY_UNISTOR_b_LITTLEFS_manager_part.h"
     #include "BSY_UNISTOR_b_LITTLEFS_part.h"
     #include "BSY_UNISTOR_c_LITTLEFS_util_part.h"
+    #include "BSY_UNISTOR_d_LITTLEFS_ringlog_part.h"
+    #include "BSY_UNISTOR_e_LITTLEFS_counter_part.h"
 #endif
+#include "BSY_UNISTOR_f_unified_part.h"
 
 
 
@@ -0,0 +1,160 @@
+#ifndef BSY_UNISTOR_0_CHECKSUM_PART_H
+#define BSY_UNISTOR_0_CHECKSUM_PART_H
+
+/**
+ * Политики контрольной суммы для хранилищ.
+ * Любая политика умеет считать сумму как целиком (calc), так и потоково,
+ * кусками по мере чтения/записи файла (begin -> update ... -> finish).
+ * Своя политика - любой класс с таким же набором методов и полем id.
+ */
+
+/**
+ * @struct StorageCrc32
+ * @brief CRC32 (IEEE 802.3) через crc32_le из ROM ESP32 - формат по умолчанию
+ */
+struct StorageCrc32 {
+    static constexpr uint8_t id = 0;
+
+    uint32_t _crc = 0;
+
+    void begin() { _crc = 0; }
+
+    /**
+     * Добавить очередной кусок данных
+     * @param data Указатель на данные
+     * @param len Длина куска
+     */
+    void update(const void* data, size_t len) {
+        _crc = crc32_le(_crc, (const uint8_t*)data, len);
+    }
+
+    uint32_t finish() const { return _crc; }
+
+    /**
+     * Сумма блока целиком
+     */
+    static uint32_t calc(const void* data, size_t len) {
+        return crc32_le(0, (const uint8_t*)data, len);
+    }
+};
+
+/**
+ * @struct StorageXxHash32
+ * @brief xxHash32 (seed 0) - дешевле CRC32 на больших блоках, ловит те же случайные повреждения
+ */
+struct StorageXxHash32 {
+    static constexpr uint8_t id = 1;
+
+    static constexpr uint32_t P1 = 2654435761U;
+    static constexpr uint32_t P2 = 2246822519U;
+    static constexpr uint32_t P3 = 3266489917U;
+    static constexpr uint32_t P4 = 668265263U;
+    static constexpr uint32_t P5 = 374761393U;
+
+    uint32_t _v[4];
+    uint8_t _tail[16];      // хвост, не добравший до полной 16-байтной полосы
+    uint8_t _tailLen = 0;
+    uint32_t _total = 0;
+
+    static uint32_t rotl(uint32_t x, uint8_t r) { return (x << r) | (x >> (32 - r)); }
+
+    static uint32_t read32(const uint8_t* p) {
+        uint32_t v;
+        memcpy(&v, p, 4);
+        return v;
+    }
+
+    static uint32_t round(uint32_t acc, uint32_t input) {
+        acc += input * P2;
+        acc = rotl(acc, 13);
+        return acc * P1;
+    }
+
+    void stripe(const uint8_t* p) {
+        _v[0] = round(_v[0], read32(p));
+        _v[1] = round(_v[1], read32(p + 4));
+        _v[2] = round(_v[2], read32(p + 8));
+        _v[3] = round(_v[3], read32(p + 12));
+    }
+
+    void begin() {
+        _v[0] = P1 + P2;
+        _v[1] = P2;
+        _v[2] = 0;
+        _v[3] = 0 - P1;
+        _tailLen = 0;
+        _total = 0;
+    }
+
+    /**
+     * Добавить очередной кусок данных
+     * @param data Указатель на данные
+     * @param len Длина куска
+     */
+    void update(const void* data, size_t len) {
+        const uint8_t* p = (const uint8_t*)data;
+        _total += len;
+
+        if (_tailLen) {
+            size_t fill = 16 - _tailLen;
+            if (len < fill) {
+                memcpy(_tail + _tailLen, p, len);
+                _tailLen += len;
+                return;
+            }
+            memcpy(_tail + _tailLen, p, fill);
+            stripe(_tail);
+            p += fill;
+            len -= fill;
+            _tailLen = 0;
+        }
+        while (len >= 16) {
+            stripe(p);
+            p += 16;
+            len -= 16;
+        }
+        if (len) {
+            memcpy(_tail, p, len);
+            _tailLen = len;
+        }
+    }
+
+    uint32_t finish() const {
+        uint32_t h = (_total >= 16)
+            ? rotl(_v[0], 1) + rotl(_v[1], 7) + rotl(_v[2], 12) + rotl(_v[3], 18)
+            : P5;
+        h += _total;
+
+        const uint8_t* p = _tail;
+        size_t len = _tailLen;
+        while (len >= 4) {
+            h += read32(p) * P3;
+            h = rotl(h, 17) * P4;
+            p += 4;
+            len -= 4;
+        }
+        while (len--) {
+            h += (*p++) * P5;
+            h = rotl(h, 11) * P1;
+        }
+
+        h ^= h >> 15;
+        h *= P2;
+        h ^= h >> 13;
+        h *= P3;
+        h ^= h >> 16;
+        return h;
+    }
+
+    /**
+     * Сумма блока целиком
+     */
+    static uint32_t calc(const void* data, size_t len) {
+        StorageXxHash32 x;
+        x.begin();
+        x.update(data, len);
+        return x.finish();
+    }
+};
+
+#endif
@@ -0,0 +1,162 @@
+#ifndef BSY_UNISTOR_0_CODEC_PART_H
+#define BSY_UNISTOR_0_CODEC_PART_H
+
+/**
+ * Политики сжатия для StorageBigAkaFileSys.
+ * Политика определяет только запись: читаются файлы любого известного формата,
+ * id формата хранится в заголовке файла.
+ */
+
+/**
+ * @struct StorageRawCodec
+ * @brief Без сжатия (по умолчанию)
+ */
+struct StorageRawCodec {
+    static constexpr uint8_t id = 0;
+};
+
+/**
+ * @class StorageRleCodec
+ * @brief RLE в стиле PackBits: повторы от 3 байт - 2 байта, остальное - литералами.
+ * Хорошо жмет таблицы, которые в основном заполнены нулями или одинаковыми значениями.
+ * Кодер и декодер потоковые, без выделения памяти.
+ *
+ * Управляющий байт c: 0..127 - дальше c+1 байт как есть;
+ * 128..255 - следующий байт повторить c-125 раз (3..130)
+ */
+class StorageRleCodec {
+private:
+    static constexpr size_t MAX_LITERAL = 128;
+    static constexpr size_t MIN_RUN = 3;
+    static constexpr size_t MAX_RUN = 130;
+
+    /**
+     * Буфер вывода кодера: мелкие куски копятся и уходят в sink одним вызовом
+     */
+    template <typename Sink>
+    struct Writer {
+        Sink& sink;
+        uint8_t buf[64];
+        size_t used = 0;
+        size_t total = 0;
+        bool ok = true;
+
+        explicit Writer(Sink& s) : sink(s) {}
+
+        void put(const uint8_t* p, size_t n) {
+            total += n;
+            if (!ok) return;
+            while (n) {
+                size_t len = sizeof(buf) - used;
+                if (len > n) len = n;
+                memcpy(buf + used, p, len);
+                used += len;
+                p += len;
+                n -= len;
+                if (used == sizeof(buf)) flush();
+            }
+        }
+
+        void flush() {
+            if (used && ok) ok = sink(buf, used);
+            used = 0;
+        }
+    };
+
+    struct CountSink {
+        bool operator()(const uint8_t*, size_t) { return true; }
+    };
+
+public:
+    static constexpr uint8_t id = 1;
+
+    /**
+     * Сжатие потоком
+     * @param src Данные
+     * @param len Размер данных
+     * @param sink Приемник: bool(const uint8_t* p, size_t n)
+     * @return Размер сжатых данных (0 - ошибка записи)
+     */
+    template <typename Sink>
+    static size_t encode(const uint8_t* src, size_t len, Sink& sink) {
+        Writer<Sink> w(sink);
+        size_t i = 0;
+        while (i < len) {
+            size_t run = 1;
+            while (i + run < len && run < MAX_RUN && src[i + run] == src[i]) run++;
+            if (run >= MIN_RUN) {
+                uint8_t code[2] = { (uint8_t)(run - MIN_RUN + 128), src[i] };
+                w.put(code, 2);
+                i += run;
+                continue;
+            }
+            // Литерал до начала следующего повтора
+            size_t start = i;
+            while (i < len && i - start < MAX_LITERAL) {
+                if (i + 2 < len && src[i] == src[i + 1] && src[i] == src[i + 2]) break;
+                i++;
+            }
+            uint8_t code = (uint8_t)(i - start - 1);
+            w.put(&code, 1);
+            w.put(src + start, i - start);
+        }
+        w.flush();
+        return w.ok ? w.total : 0;
+    }
+
+    /**
+     * Размер сжатых данных без записи (чтобы решить, стоит ли сжимать)
+     */
+    static size_t encodedSize(const uint8_t* src, size_t len) {
+        CountSink sink;
+        return encode(src, len, sink);
+    }
+
+    /**
+     * Распаковка потоком
+     * @param read Источник: size_t(uint8_t* p, size_t n), возвращает прочитанное
+     * @param storedLen Размер сжатых данных
+     * @param dst Куда распаковать
+     * @param dstLen Ожидаемый размер распакованных данных
+     * @return true если сжатые данные прочитаны до конца и дали ровно dstLen байт
+     */
+    template <typename Read>
+    static bool decode(Read& read, size_t storedLen, uint8_t* dst, size_t dstLen) {
+        uint8_t buf[64];
+        size_t have = 0, pos = 0;
+        size_t out = 0;
+        // Следующий байт сжатого потока, с подкачкой буфера
+        auto next = [&](uint8_t& b) {
+            if (pos == have) {
+                if (!storedLen) return false;
+                size_t n = storedLen < sizeof(buf) ? storedLen : sizeof(buf);
+                if (read(buf, n) != n) return false;
+                storedLen -= n;
+                have = n;
+                pos = 0;
+            }
+            b = buf[pos++];
+            return true;
+        };
+
+        uint8_t c;
+        while (next(c)) {
+            if (c < 128) {
+                size_t n = (size_t)c + 1;
+                if (out + n > dstLen) return false;
+                for (size_t k = 0; k < n; k++) {
+                    if (!next(dst[out++])) return false;
+                }
+            } else {
+                size_t n = (size_t)c - 128 + MIN_RUN;
+                uint8_t v;
+                if (out + n > dstLen || !next(v)) return false;
+                memset(dst + out, v, n);
+                out += n;
+            }
+        }
+        return out == dstLen && pos == have && !storedLen;
+    }
+};
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef BSY_UNISTOR_0_LOCK_PART_H
+#define BSY_UNISTOR_0_LOCK_PART_H
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+/**
+ * Политики блокировки для хранилищ.
+ * StorageNoLock ничего не стоит, StorageMutexLock - рекурсивный мьютекс FreeRTOS
+ * для работы с одним объектом из нескольких задач/ядер.
+ */
+
+/**
+ * @struct StorageNoLock
+ * @brief Без блокировок (однопоточное использование)
+ */
+struct StorageNoLock {
+    static constexpr bool enabled = false;
+    void lock() {}
+    void unlock() {}
+};
+
+/**
+ * @class StorageMutexLock
+ * @brief Рекурсивный мьютекс: одна задача может брать его повторно
+ */
+class StorageMutexLock {
+private:
+    SemaphoreHandle_t _m;
+public:
+    static constexpr bool enabled = true;
+
+    StorageMutexLock() : _m(xSemaphoreCreateRecursiveMutex()) {}
+    StorageMutexLock(const StorageMutexLock&) = delete;
+    StorageMutexLock& operator=(const StorageMutexLock&) = delete;
+
+    void lock() { if (_m) xSemaphoreTakeRecursive(_m, portMAX_DELAY); }
+    void unlock() { if (_m) xSemaphoreGiveRecursive(_m); }
+};
+
+// Политика по умолчанию задаётся флагом сборки -D STORAGE_THREAD_SAFE
+#ifdef STORAGE_THREAD_SAFE
+using StorageDefaultLock = StorageMutexLock;
+#else
+using StorageDefaultLock = StorageNoLock;
+#endif
+
+/**
+ * @class StorageLockGuard
+ * @brief RAII-захват любого объекта с lock()/unlock() (политики или хранилища)
+ * @code
+ * {
+ *     StorageLockGuard g(fsLog);   // данные не попадут в снимок наполовину измененными
+ *     myLog.temps[i] = t;
+ *     fsLog.update();
+ * }
+ * @endcode
+ */
+template <typename L>
+class StorageLockGuard {
+private:
+    L& _l;
+public:
+    explicit StorageLockGuard(L& l) : _l(l) { _l.lock(); }
+    ~StorageLockGuard() { _l.unlock(); }
+    StorageLockGuard(const StorageLockGuard&) = delete;
+    StorageLockGuard& operator=(const StorageLockGuard&) = delete;
+};
+
+#endif
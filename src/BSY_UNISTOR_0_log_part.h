@@ -0,0 +1,154 @@
+#ifndef BSY_UNISTOR_0_LOG_PART_H
+#define BSY_UNISTOR_0_LOG_PART_H
+
+#if STORAGE_LOG_SINK == STORAGE_LOG_SINK_ESP_LOG
+    #include <esp_log.h>
+#endif
+
+/**
+ * @class StorageLog
+ * @brief Вывод журнала библиотеки (макрос ST_LOG).
+ * Строка собирается в стеке (до STORAGE_LOG_LINE_MAX символов) и уходит в callback,
+ * если он задан, иначе - в выход STORAGE_LOG_SINK
+ * @code
+ * // -D STORAGE_LOG_SINK=STORAGE_LOG_SINK_RING: save()/load() не ждут UART
+ * void loop() {
+ *     StorageLog::drain(Serial);  // вывести накопленное, когда есть время
+ * }
+ * @endcode
+ */
+class StorageLog {
+public:
+    /**
+     * @param level Уровень (STORAGE_LOG_ERROR...STORAGE_LOG_DEBUG)
+     * @param msg Текст без префикса времени и уровня
+     * @param ctx Указатель из setCallback()
+     */
+    typedef void (*Callback)(uint8_t level, const char* msg, void* ctx);
+
+private:
+    inline static Callback _callback = nullptr;
+    inline static void* _callbackCtx = nullptr;
+
+#if STORAGE_LOG_SINK == STORAGE_LOG_SINK_RING
+    inline static char _ring[STORAGE_LOG_RING_SIZE];
+    inline static size_t _head = 0;   // сюда пишется следующий символ
+    inline static size_t _used = 0;
+    inline static uint32_t _dropped = 0;
+    inline static portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+
+    /**
+     * Положить строку в буфер целиком; не влезла - строка теряется, а не перезаписывает старые
+     */
+    static void push(const char* s, size_t len) {
+        portENTER_CRITICAL(&_mux);
+        if (len > sizeof(_ring) - _used) {
+            _dropped++;
+        } else {
+            for (size_t i = 0; i < len; i++) {
+                _ring[_head] = s[i];
+                _head = (_head + 1) % sizeof(_ring);
+            }
+            _used += len;
+        }
+        portEXIT_CRITICAL(&_mux);
+    }
+#endif
+
+    static const char* levelName(uint8_t level) {
+        return level == STORAGE_LOG_ERROR ? "ERROR" : level == STORAGE_LOG_WARNING ? "WARN" :
+               level == STORAGE_LOG_INFO ? "INFO" : "DEBUG";
+    }
+
+public:
+    /**
+     * Перехватить журнал: строки идут в fn вместо STORAGE_LOG_SINK (nullptr - вернуть как было).
+     * fn вызывается из той задачи, что пишет в журнал (в том числе из StorageWriter),
+     * и не должна сама работать с хранилищами
+     * @param fn Обработчик
+     * @param ctx Произвольный указатель, передаётся в обработчик
+     */
+    static void setCallback(Callback fn, void* ctx = nullptr) {
+        _callbackCtx = ctx;
+        _callback = fn;
+    }
+
+    /**
+     * Записать строку (используется макросом ST_LOG)
+     */
+    __attribute__((format(printf, 2, 3)))
+    static void write(uint8_t level, const char* fmt, ...) {
+        char line[STORAGE_LOG_LINE_MAX];
+        int prefix = snprintf(line, sizeof(line), "[%lu][STORAGE][%s] ",
+                              (unsigned long)millis(), levelName(level));
+        if (prefix < 0 || prefix >= (int)sizeof(line) - 1) return;
+
+        va_list args;
+        va_start(args, fmt);
+        int n = vsnprintf(line + prefix, sizeof(line) - prefix, fmt, args);
+        va_end(args);
+        if (n < 0) return;
+        size_t len = prefix + n;
+        if (len > sizeof(line) - 1) len = sizeof(line) - 1;  // обрезано
+
+        Callback cb = _callback;
+        if (cb) {
+            cb(level, line + prefix, _callbackCtx);
+            return;
+        }
+#if STORAGE_LOG_SINK == STORAGE_LOG_SINK_ESP_LOG
+        esp_log_level_t espLevel = level == STORAGE_LOG_ERROR ? ESP_LOG_ERROR :
+                                   level == STORAGE_LOG_WARNING ? ESP_LOG_WARN :
+                                   level == STORAGE_LOG_INFO ? ESP_LOG_INFO : ESP_LOG_DEBUG;
+        esp_log_write(espLevel, "STORAGE", "%c (%lu) STORAGE: %s\n", levelName(level)[0],
+                      (unsigned long)millis(), line + prefix);
+#elif STORAGE_LOG_SINK == STORAGE_LOG_SINK_RING
+        line[len] = '\n';
+        push(line, len + 1);
+#else
+        line[len] = '\n';
+        Serial.write((const uint8_t*)line, len + 1);
+#endif
+    }
+
+#if STORAGE_LOG_SINK == STORAGE_LOG_SINK_RING
+    /**
+     * Забрать накопленный текст из кольцевого буфера
+     * @param buf Куда
+     * @param size Размер buf
+     * @return Сколько байт забрано
+     */
+    static size_t read(char* buf, size_t size) {
+        portENTER_CRITICAL(&_mux);
+        size_t n = _used < size ? _used : size;
+        size_t tail = (_head + sizeof(_ring) - _used) % sizeof(_ring);
+        for (size_t i = 0; i < n; i++) buf[i] = _ring[(tail + i) % sizeof(_ring)];
+        _used -= n;
+        portEXIT_CRITICAL(&_mux);
+        return n;
+    }
+
+    /**
+     * Вывести всё накопленное (например, в Serial) - вызывать из loop()
+     * @param out Куда выводить
+     * @return Сколько байт выведено
+     */
+    static size_t drain(Print& out) {
+        char buf[64];
+        size_t total = 0;
+        size_t n;
+        while ((n = read(buf, sizeof(buf))) > 0) {
+            out.write((const uint8_t*)buf, n);
+            total += n;
+        }
+        return total;
+    }
+
+    /**
+     * Сколько строк потеряно из-за переполнения буфера
+     */
+    static uint32_t dropped() { return _dropped; }
+#endif
+};
+
+#endif
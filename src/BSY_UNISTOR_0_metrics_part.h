@@ -0,0 +1,172 @@
+#ifndef BSY_UNISTOR_0_METRICS_PART_H
+#define BSY_UNISTOR_0_METRICS_PART_H
+
+/**
+ * Счетчики работы с флешем (-D STORAGE_METRICS). Без флага не компилируются
+ * и ничего не стоят: ST_METRIC(...) раскрывается в пустоту
+ */
+#ifdef STORAGE_METRICS
+#include <esp_timer.h>
+
+/**
+ * @struct StorageLatency
+ * @brief Время операций: количество, min/avg/max в микросекундах
+ */
+struct StorageLatency {
+    uint32_t count = 0;
+    uint32_t minUs = 0;
+    uint32_t maxUs = 0;
+    uint64_t totalUs = 0;
+
+    void add(uint32_t us) {
+        if (!count || us < minUs) minUs = us;
+        if (us > maxUs) maxUs = us;
+        totalUs += us;
+        count++;
+    }
+
+    void merge(const StorageLatency& o) {
+        if (!o.count) return;
+        if (!count || o.minUs < minUs) minUs = o.minUs;
+        if (o.maxUs > maxUs) maxUs = o.maxUs;
+        totalUs += o.totalUs;
+        count += o.count;
+    }
+
+    uint32_t avgUs() const { return count ? (uint32_t)(totalUs / count) : 0; }
+};
+
+/**
+ * @struct StorageMetrics
+ * @brief Счетчики одного неймспейса NVS или одного файлового объекта
+ */
+struct StorageMetrics {
+    StorageLatency load;     // загрузки (count - сколько раз читали)
+    StorageLatency save;     // записи во флеш (count - сколько раз писали)
+    uint32_t throttled = 0;  // отложено (защита от частых записей, OTA)
+    uint32_t skipped = 0;    // не записано: данные во флеше уже такие (или только в RTC-копии)
+    uint32_t crcErrors = 0;
+    uint32_t failures = 0;   // ошибки записи
+    uint64_t bytesWritten = 0;
+
+    void merge(const StorageMetrics& o) {
+        load.merge(o.load);
+        save.merge(o.save);
+        throttled += o.throttled;
+        skipped += o.skipped;
+        crcErrors += o.crcErrors;
+        failures += o.failures;
+        bytesWritten += o.bytesWritten;
+    }
+};
+
+/**
+ * @class StorageMetricsSource
+ * @brief Счетчики объекта хранилища в общем реестре (для снимка всех сразу)
+ * @code
+ * StorageMetricsSource::forEach([](const StorageMetricsSource& s, void*) {
+ *     Serial.printf("%s: %u saves, %llu bytes\n", s.name(), s.metrics().save.count,
+ *                   s.metrics().bytesWritten);
+ * });
+ * @endcode
+ */
+class StorageMetricsSource {
+public:
+    enum Kind : uint8_t { NVS, FS };
+
+private:
+    inline static StorageMetricsSource* _head = nullptr;
+    inline static portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+    StorageMetricsSource* _next = nullptr;
+    const char* _name;
+    Kind _kind;
+
+    void attach() {
+        portENTER_CRITICAL(&_mux);
+        _next = _head;
+        _head = this;
+        portEXIT_CRITICAL(&_mux);
+    }
+
+public:
+    StorageMetrics m;
+
+    StorageMetricsSource(const char* name, Kind kind) : _name(name), _kind(kind) { attach(); }
+
+    // Копия объекта хранилища - отдельный источник со своими счетчиками
+    StorageMetricsSource(const StorageMetricsSource& o) : _name(o._name), _kind(o._kind) { attach(); }
+    StorageMetricsSource& operator=(const StorageMetricsSource&) { return *this; }
+
+    ~StorageMetricsSource() {
+        portENTER_CRITICAL(&_mux);
+        for (StorageMetricsSource** p = &_head; *p; p = &(*p)->_next) {
+            if (*p == this) {
+                *p = _next;
+                break;
+            }
+        }
+        portEXIT_CRITICAL(&_mux);
+    }
+
+    const char* name() const { return _name; }
+    Kind kind() const { return _kind; }
+    const StorageMetrics& metrics() const { return m; }
+
+    /**
+     * Обход всех источников (неймспейсы NVS и файловые объекты)
+     * @param fn Обработчик
+     * @param ctx Произвольный указатель, передаётся в обработчик
+     */
+    static void forEach(void (*fn)(const StorageMetricsSource& s, void* ctx), void* ctx = nullptr) {
+        for (StorageMetricsSource* s = _head; s; s = s->_next) fn(*s, ctx);
+    }
+
+    /**
+     * Сумма по всем источникам
+     */
+    static StorageMetrics total() {
+        StorageMetrics sum;
+        for (StorageMetricsSource* s = _head; s; s = s->_next) sum.merge(s->m);
+        return sum;
+    }
+
+    /**
+     * Сумма только по NVS или только по файлам
+     */
+    static StorageMetrics total(Kind kind) {
+        StorageMetrics sum;
+        for (StorageMetricsSource* s = _head; s; s = s->_next) {
+            if (s->_kind == kind) sum.merge(s->m);
+        }
+        return sum;
+    }
+
+    /**
+     * Обнулить счетчики всех источников
+     */
+    static void resetAll() {
+        for (StorageMetricsSource* s = _head; s; s = s->_next) s->m = StorageMetrics();
+    }
+};
+
+/**
+ * @class StorageMetricTimer
+ * @brief Замер времени операции до конца области видимости
+ */
+class StorageMetricTimer {
+private:
+    StorageLatency& _lat;
+    int64_t _start;
+public:
+    explicit StorageMetricTimer(StorageLatency& lat) : _lat(lat), _start(esp_timer_get_time()) {}
+    ~StorageMetricTimer() { _lat.add((uint32_t)(esp_timer_get_time() - _start)); }
+    StorageMetricTimer(const StorageMetricTimer&) = delete;
+    StorageMetricTimer& operator=(const StorageMetricTimer&) = delete;
+};
+
+    #define ST_METRIC(x) x
+#else
+    #define ST_METRIC(x)
+#endif
+
+#endif
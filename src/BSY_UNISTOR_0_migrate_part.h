@@ -0,0 +1,111 @@
+#ifndef BSY_UNISTOR_0_MIGRATE_PART_H
+#define BSY_UNISTOR_0_MIGRATE_PART_H
+
+/**
+ * Шаг миграции: переводит данные версии N в версию N+1 прямо в буфере
+ * @param data Буфер с данными старой версии (вмещает capacity байт)
+ * @param size Размер данных старой версии
+ * @param capacity Размер буфера
+ * @return Размер данных новой версии (0 - ошибка)
+ */
+typedef size_t (*StorageMigration)(uint8_t* data, size_t size, size_t capacity);
+
+/**
+ * @class StorageMigrations
+ * @brief Цепочка миграций v1 -> v2 -> v3 ... для StorageSmallAkaNVS::load()
+ * и StorageBigAkaFileSys::setVersion(). Применяется в RAM при загрузке,
+ * результат записывается обратно при следующей штатной записи
+ * @code
+ * // v1: struct CfgV1 { int port; };   v2: struct Cfg { int port; int timeout; };
+ * size_t cfg1to2(uint8_t* data, size_t size, size_t capacity) {
+ *     if (size != sizeof(CfgV1) || capacity < sizeof(Cfg)) return 0;
+ *     Cfg c;
+ *     memcpy(&c.port, data, sizeof(c.port));
+ *     c.timeout = 30;
+ *     memcpy(data, &c, sizeof(c));
+ *     return sizeof(c);
+ * }
+ * StorageMigrations cfgMigrations;
+ * cfgMigrations.add(1, cfg1to2);
+ * nvs.load("cfg", cfg, 2, cfgMigrations);
+ * @endcode
+ */
+class StorageMigrations {
+private:
+    struct Step {
+        uint8_t from;
+        StorageMigration fn;
+    };
+    Step _steps[STORAGE_MIGRATION_MAX];
+    uint8_t _count = 0;
+    size_t _maxSize;
+
+public:
+    /**
+     * @param maxSize Размер самой большой промежуточной версии, если она больше
+     * и хранимой, и текущей (0 - не больше)
+     */
+    explicit StorageMigrations(size_t maxSize = 0) : _maxSize(maxSize) {}
+
+    /**
+     * Добавить шаг миграции
+     * @param fromVersion Версия, которую шаг переводит в fromVersion + 1
+     * @param fn Функция миграции (nullptr - формат не менялся, только номер версии)
+     * @return Ссылка на цепочку для вызовов подряд
+     */
+    StorageMigrations& add(uint8_t fromVersion, StorageMigration fn) {
+        if (_count >= STORAGE_MIGRATION_MAX) {
+            ST_LOG(STORAGE_LOG_ERROR, "Migration: chain is full (max %u steps)", STORAGE_MIGRATION_MAX);
+            return *this;
+        }
+        _steps[_count++] = { fromVersion, fn };
+        return *this;
+    }
+
+    /**
+     * Минимальный размер буфера миграции для данных указанных размеров
+     */
+    size_t capacityFor(size_t storedSize, size_t currentSize) const {
+        size_t cap = storedSize > currentSize ? storedSize : currentSize;
+        return cap > _maxSize ? cap : _maxSize;
+    }
+
+    /**
+     * Провести данные по цепочке от версии from до версии to
+     * @param data Буфер с данными
+     * @param size Размер данных (на выходе - размер после миграции)
+     * @param capacity Размер буфера
+     * @param from Хранимая версия
+     * @param to Требуемая версия
+     * @return true если все шаги от from до to найдены и выполнены
+     */
+    bool apply(uint8_t* data, size_t& size, size_t capacity, uint8_t from, uint8_t to) const {
+        if (from > to) {
+            ST_LOG(STORAGE_LOG_WARNING, "Migration: can't downgrade v%u -> v%u", from, to);
+            return false;
+        }
+        while (from < to) {
+            const Step* step = nullptr;
+            for (uint8_t i = 0; i < _count; i++) {
+                if (_steps[i].from == from) { step = &_steps[i]; break; }
+            }
+            if (!step) {
+                ST_LOG(STORAGE_LOG_WARNING, "Migration: no step from v%u", from);
+                return false;
+            }
+            if (step->fn) {
+                size_t n = step->fn(data, size, capacity);
+                if (!n || n > capacity) {
+                    ST_LOG(STORAGE_LOG_ERROR, "Migration: step v%u -> v%u failed", from, from + 1);
+                    return false;
+                }
+                size = n;
+            }
+            ST_LOG(STORAGE_LOG_DEBUG, "Migration: v%u -> v%u (size: %u)", from, from + 1, (uint32_t)size);
+            from++;
+        }
+        return true;
+    }
+};
+
+#endif
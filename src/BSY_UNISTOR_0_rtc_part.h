@@ -0,0 +1,165 @@
+#ifndef BSY_UNISTOR_0_RTC_PART_H
+#define BSY_UNISTOR_0_RTC_PART_H
+#include <esp_system.h>
+#if __has_include(<esp_random.h>)
+    #include <esp_random.h>
+#endif
+
+/**
+ * @class StorageRtcSession
+ * @brief Текущая загрузка для всех RTC-копий: причина сброса проверяется один раз,
+ * а копия, запечатанная в этой загрузке, действительна до следующего сброса
+ */
+class StorageRtcSession {
+private:
+    inline static uint32_t _id = 0;        // в RAM: обнуляется при каждой загрузке
+    inline static int8_t _retained = -1;   // -1 - причина сброса ещё не проверялась
+
+public:
+    /**
+     * Номер загрузки (случайный, чтобы не совпасть с номером прошлой загрузки в RTC-памяти)
+     */
+    static uint32_t id() {
+        if (!_id) _id = esp_random() | 1;
+        return _id;
+    }
+
+    /**
+     * Сохранил ли сброс, с которого началась загрузка, RTC-память
+     */
+    static bool retained() {
+        if (_retained < 0) {
+            switch (esp_reset_reason()) {
+                case ESP_RST_DEEPSLEEP:
+                case ESP_RST_SW:
+                case ESP_RST_PANIC:
+                case ESP_RST_INT_WDT:
+                case ESP_RST_TASK_WDT:
+                case ESP_RST_WDT:
+                    _retained = 1;
+                    break;
+                default:
+                    _retained = 0;
+            }
+        }
+        return _retained == 1;
+    }
+
+    /**
+     * Начать новую загрузку без сброса (тесты на ПК: имитация перезагрузки)
+     */
+    static void restart() {
+        _id = 0;
+        _retained = -1;
+    }
+};
+
+/**
+ * @struct StorageRtcShadow
+ * @brief Копия объекта в RTC-памяти, переживающая deep sleep (и программный сброс).
+ * Объявляется пользователем глобально с RTC_NOINIT_ATTR (RTC slow memory ~8 КБ):
+ * @code
+ * RTC_NOINIT_ATTR StorageRtcShadow<Cfg> cfgShadow;
+ * nvs.load("cfg", cfg, 1, cfgShadow);        // после deep sleep - из RTC, без флеша
+ * nvs.save("cfg", cfg, 1, cfgShadow, 10);    // во флеш - раз в 10 циклов с изменениями
+ * fsBig.setRtcShadow(&bigShadow, 10);        // то же для StorageBigAkaFileSys
+ * @endcode
+ * Копия из RTC-памяти принимается при сбросе, сохраняющем её (deep sleep, программный,
+ * паника, watchdog), и при совпадении суммы; после включения питания или brownout
+ * данные берутся из флеша, а копия заполняется ими и дальше действует до следующего сброса.
+ * В счетчик writeEvery идут только сохранения, изменившие данные. Изменения последних
+ * циклов (до writeEvery-1) при пропадании питания теряются - для критичных данных
+ * звать запись во флеш явно
+ * @tparam T Тип хранимых данных
+ * @tparam Checksum Политика контрольной суммы
+ */
+template <typename T, typename Checksum = StorageCrc32>
+struct StorageRtcShadow {
+    static constexpr uint32_t MAGIC = 0x43545242;  // "BRTC"
+
+    uint32_t magic;
+    uint32_t crc;        // сумма полей size..data
+    uint16_t size;
+    uint16_t cycles;     // сохранений с изменениями с последней записи во флеш
+    uint8_t pending;     // во флеше более старая версия
+    uint8_t reserved[3];
+    uint32_t session;    // StorageRtcSession::id() загрузки, в которой копия запечатана
+    T data;
+
+    uint32_t calc() const {
+        return Checksum::calc(&size, sizeof(*this) - offsetof(StorageRtcShadow, size));
+    }
+
+    void seal() {
+        magic = MAGIC;
+        size = (uint16_t)sizeof(T);  // больше 64 КБ в RTC-память всё равно не влезет
+        session = StorageRtcSession::id();
+        crc = calc();
+    }
+
+    /**
+     * @return true если в RTC-памяти целая копия объекта этого типа
+     */
+    bool valid() const {
+        return magic == MAGIC && size == sizeof(T) && crc == calc();
+    }
+
+    /**
+     * Взять данные из RTC-копии
+     * @return true если копия валидна и скопирована в out
+     */
+    bool restore(T& out) const {
+        if (!valid() || (session != StorageRtcSession::id() && !StorageRtcSession::retained())) return false;
+        memcpy((void*)&out, &data, sizeof(T));
+        return true;
+    }
+
+    /**
+     * Запомнить данные, только что прочитанные из флеша (флеш и копия совпадают)
+     */
+    void adopt(const T& in) {
+        memcpy((void*)&data, &in, sizeof(T));
+        cycles = 0;
+        pending = 0;
+        seal();
+    }
+
+    /**
+     * Сохранить данные в RTC-копию
+     * @param in Данные
+     * @param writeEvery Раз во сколько сохранений писать изменения во флеш (0/1 - каждый раз)
+     * @return true если пора писать во флеш
+     */
+    bool store(const T& in, uint16_t writeEvery) {
+        bool fresh = !valid();  // в RTC-памяти мусор (load() не вызывался)
+        if (fresh) {
+            cycles = 0;
+            pending = 0;
+        }
+        if (fresh || memcmp(&data, &in, sizeof(T))) {
+            memcpy((void*)&data, &in, sizeof(T));
+            pending = 1;
+            if (cycles < UINT16_MAX) cycles++;
+            seal();
+        }
+        return pending && cycles >= writeEvery;
+    }
+
+    /**
+     * Отметить, что данные записаны во флеш
+     */
+    void markWritten() {
+        cycles = 0;
+        pending = 0;
+        seal();
+    }
+
+    /**
+     * Сбросить копию (следующий load() пойдет во флеш)
+     */
+    void invalidate() {
+        magic = 0;
+    }
+};
+
+#endif
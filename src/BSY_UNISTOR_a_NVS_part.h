@@ -1,7 +1,9 @@
 #ifndef BSY_UNISTOR_A_NVS_PART_H
 #define BSY_UNISTOR_A_NVS_PART_H
 #include <Preferences.h>
+#include <nvs.h>
 #include <memory>
+#include <type_traits>
 //#include "BSY_ESP32_UniversalStorages.h" //чтоб система не ругалась на отсутствие определения ST_LOG
 
 /**
@@ -11,9 +13,16 @@
 class StorageSmallAkaNVS {
 private:
     const char* _ns;
+#ifdef STORAGE_METRICS
+    StorageMetricsSource _metrics{_ns, StorageMetricsSource::NVS};
+#endif
     Preferences _prefs;
     uint32_t _minSaveInterval = 1000;
-    uint32_t _lastSaveTime = 0;
+    uint8_t _batchDepth = 0;     // глубина вложенности пакетных сессий
+    bool _batchOpen = false;     // неймспейс удерживается открытым на запись
+    nvs_handle_t _batchNvs = 0;  // дескриптор записей пакетной сессии (коммит в endBatch)
+    bool _batchOk = true;        // все записи пакетной сессии прошли
+    bool _sizeTolerant = false;  // загружать общий префикс, если размер структуры изменился
     
     #pragma pack(push, 1)
     template <typename T>
@@ -25,6 +34,506 @@ private:
     };
     #pragma pack(pop)
 
+    // Общий буфер для больших пакетов: живёт в .bss, не в стеке и не в куче.
+    // Один на все объекты, поэтому защищен _scratchLock всегда, а не только при STORAGE_THREAD_SAFE
+    alignas(4) inline static uint8_t _scratch[NVS_MAX_SIZE];
+    inline static StorageMutexLock _scratchLock;
+
+    // Блокировка объекта: его Preferences, кэш и слоты не потокобезопасны.
+    // Без STORAGE_THREAD_SAFE - пустышка StorageNoLock
+    StorageDefaultLock _lock;
+
+    /**
+     * @class ScratchGuard
+     * @brief Захват общего _scratch. Порядок захвата: сначала _lock объекта, затем этот
+     */
+    class ScratchGuard {
+    private:
+        bool _held;
+    public:
+        explicit ScratchGuard(bool needed = true) : _held(needed) { if (_held) _scratchLock.lock(); }
+        ~ScratchGuard() { if (_held) _scratchLock.unlock(); }
+        ScratchGuard(const ScratchGuard&) = delete;
+        ScratchGuard& operator=(const ScratchGuard&) = delete;
+    };
+
+    template <typename T>
+    static constexpr bool usesScratch() { return sizeof(Package<T>) > NVS_STACK_PACKAGE_MAX; }
+
+    // Маленький пакет держим прямо в стеке, для большого - пустышка-заглушка
+    template <typename T>
+    using PackageHolder = typename std::conditional<
+        (sizeof(Package<T>) <= NVS_STACK_PACKAGE_MAX), Package<T>, uint8_t>::type;
+
+    /**
+     * Место под пакет без выделения памяти: стек для маленьких типов,
+     * статический _scratch для больших (вплоть до NVS_MAX_SIZE, под ScratchGuard)
+     * @param local Переменная-держатель в стеке вызывающей функции
+     * @return Указатель на буфер пакета
+     */
+    template <typename T>
+    static Package<T>* packageBuffer(PackageHolder<T>& local) {
+        if constexpr (!usesScratch<T>()) {
+            return &local;
+        } else {
+            static_assert(alignof(Package<T>) <= 4, "Package alignment exceeds scratch buffer alignment");
+            return reinterpret_cast<Package<T>*>(_scratch);
+        }
+    }
+
+#if NVS_CRC_CACHE_SIZE > 0
+    /**
+     * @struct CacheEntry
+     * @brief Запись RAM-кэша: что сейчас лежит во флеше под ключом
+     */
+    struct CacheEntry {
+        char key[16];       // ключ NVS (max 15 символов + '\0')
+        uint32_t crc;
+        uint16_t size;      // размер пакета, чтобы не спутать разные типы под одним ключом
+        uint8_t version;
+        bool valid;
+    };
+
+    CacheEntry _cache[NVS_CRC_CACHE_SIZE] = {};
+    uint8_t _cacheNext = 0;  // следующая запись для вытеснения (по кругу)
+
+    /**
+     * Найти запись кэша по ключу
+     * @param key Имя ключа
+     * @return Указатель на запись или nullptr
+     */
+    CacheEntry* cacheFind(const char* key) {
+        for (uint8_t i = 0; i < NVS_CRC_CACHE_SIZE; i++) {
+            if (_cache[i].valid && strncmp(_cache[i].key, key, sizeof(_cache[i].key)) == 0) {
+                return &_cache[i];
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     * Запомнить CRC/версию ключа после успешной загрузки или записи
+     */
+    void cachePut(const char* key, uint32_t crc, uint8_t version, uint16_t size) {
+        CacheEntry* e = cacheFind(key);
+        if (!e) {
+            e = &_cache[_cacheNext];
+            _cacheNext = (_cacheNext + 1) % NVS_CRC_CACHE_SIZE;
+            strncpy(e->key, key, sizeof(e->key) - 1);
+            e->key[sizeof(e->key) - 1] = '\0';
+            e->valid = true;
+        }
+        e->crc = crc;
+        e->version = version;
+        e->size = size;
+    }
+
+    /**
+     * Забыть ключ (после удаления или неудачной записи)
+     */
+    void cacheDrop(const char* key) {
+        CacheEntry* e = cacheFind(key);
+        if (e) e->valid = false;
+    }
+
+    /**
+     * Сбросить весь кэш
+     */
+    void cacheClear() {
+        for (uint8_t i = 0; i < NVS_CRC_CACHE_SIZE; i++) _cache[i].valid = false;
+    }
+#else
+    void cachePut(const char*, uint32_t, uint8_t, uint16_t) {}
+    void cacheDrop(const char*) {}
+    void cacheClear() {}
+#endif
+
+    /**
+     * @struct ThrottleSlot
+     * @brief Защита от частых записей для одного ключа + отложенные данные
+     */
+    struct ThrottleSlot {
+        char key[16];
+        uint32_t lastSaveTime = 0;
+        bool used = false;
+        bool saved = false;                  // ключ уже записывался этим объектом
+        uint8_t* pending = nullptr;          // готовый Package<T>, ожидающий записи (буфер пула)
+        uint16_t pendingSize = 0;
+        uint8_t pendingBuf = 0;              // номер буфера в пуле
+    };
+
+    // Пул буферов отложенных записей: в .bss, общий для всех объектов (под ScratchGuard).
+    // Номера 0..NVS_PENDING_SMALL-1 - маленькие буферы, дальше - большие
+    static constexpr uint8_t POOL_BUFFERS = NVS_PENDING_SMALL + NVS_PENDING_LARGE;
+    static_assert(POOL_BUFFERS <= 32, "NVS_PENDING_SMALL + NVS_PENDING_LARGE must not exceed 32");
+    alignas(4) inline static uint8_t _poolSmall[NVS_PENDING_SMALL ? NVS_PENDING_SMALL : 1][NVS_STACK_PACKAGE_MAX];
+    alignas(4) inline static uint8_t _poolLarge[NVS_PENDING_LARGE ? NVS_PENDING_LARGE : 1][NVS_MAX_SIZE];
+    inline static uint32_t _poolUsed = 0;
+
+    static size_t poolCapacity(uint8_t index) {
+        return index < NVS_PENDING_SMALL ? NVS_STACK_PACKAGE_MAX : NVS_MAX_SIZE;
+    }
+
+    /**
+     * Занять буфер пула: маленький, если пакет в него помещается, иначе большой
+     * @return Номер буфера или POOL_BUFFERS, если подходящих свободных нет
+     */
+    static uint8_t poolTake(size_t size) {
+        ScratchGuard scratch;
+        for (uint8_t i = size <= NVS_STACK_PACKAGE_MAX ? 0 : NVS_PENDING_SMALL; i < POOL_BUFFERS; i++) {
+            if (_poolUsed & (1UL << i)) continue;
+            _poolUsed |= (1UL << i);
+            return i;
+        }
+        return POOL_BUFFERS;
+    }
+
+    static void poolGive(uint8_t index) {
+        ScratchGuard scratch;
+        _poolUsed &= ~(1UL << index);
+    }
+
+    static uint8_t* poolData(uint8_t index) {
+        return index < NVS_PENDING_SMALL ? _poolSmall[index] : _poolLarge[index - NVS_PENDING_SMALL];
+    }
+
+    ThrottleSlot _slots[NVS_THROTTLE_SLOTS];
+    uint8_t _pendingCount = 0;
+
+    static uint32_t elapsedSince(uint32_t since, uint32_t now) {
+        return (now >= since) ? (now - since) : (UINT32_MAX - since + now);
+    }
+
+    /**
+     * Найти слот ключа без создания
+     */
+    ThrottleSlot* findSlot(const char* key) {
+        for (uint8_t i = 0; i < NVS_THROTTLE_SLOTS; i++) {
+            if (_slots[i].used && strncmp(_slots[i].key, key, sizeof(_slots[i].key)) == 0) {
+                return &_slots[i];
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     * Найти или занять слот ключа.
+     * Вытесняется свободный слот, затем самый старый без отложенных данных.
+     * @return nullptr если все слоты заняты отложенными записями
+     */
+    ThrottleSlot* throttleSlot(const char* key) {
+        ThrottleSlot* slot = findSlot(key);
+        if (slot) return slot;
+
+        uint32_t now = millis();
+        for (uint8_t i = 0; i < NVS_THROTTLE_SLOTS; i++) {
+            ThrottleSlot& s = _slots[i];
+            if (s.pending) continue;
+            if (!s.used) { slot = &s; break; }
+            if (!slot || elapsedSince(s.lastSaveTime, now) > elapsedSince(slot->lastSaveTime, now)) {
+                slot = &s;
+            }
+        }
+        if (!slot) {
+            ST_LOG(STORAGE_LOG_WARNING, "NVS: No free throttle slot for '%s'", key);
+            return nullptr;
+        }
+        strncpy(slot->key, key, sizeof(slot->key) - 1);
+        slot->key[sizeof(slot->key) - 1] = '\0';
+        slot->used = true;
+        slot->saved = false;
+        return slot;
+    }
+
+    void dropPending(ThrottleSlot* slot) {
+        if (!slot || !slot->pending) return;
+        poolGive(slot->pendingBuf);
+        slot->pending = nullptr;
+        slot->pendingSize = 0;
+        _pendingCount--;
+    }
+
+    void dropAllSlots() {
+        for (uint8_t i = 0; i < NVS_THROTTLE_SLOTS; i++) {
+            dropPending(&_slots[i]);
+            _slots[i].used = false;
+        }
+    }
+
+    /**
+     * Запись готового пакета во флеш
+     * @param key Имя ключа
+     * @param pkg Пакет (заголовок + данные)
+     * @param size Размер пакета
+     * @param version Версия (для кэша и лога)
+     * @param crc CRC данных (для кэша и лога)
+     * @return true если записано полностью
+     */
+    bool writePackage(const char* key, const void* pkg, size_t size, uint8_t version, uint32_t crc) {
+        if (!openNs(false)) {
+            ST_LOG(STORAGE_LOG_ERROR, "NVS: Failed to open namespace '%s' for write", _ns);
+            return false;
+        }
+        
+        size_t written;
+        {
+            ST_METRIC(StorageMetricTimer timer(_metrics.m.save));
+            written = putBlob(key, pkg, size);
+        }
+        closeNs();
+        
+        if (written != size) {
+            ST_LOG(STORAGE_LOG_ERROR, "NVS: Failed to write key '%s' (written: %u, expected: %u)", 
+                   key, written, (uint32_t)size);
+            ST_METRIC(_metrics.m.failures++);
+            cacheDrop(key);
+            return false;
+        }
+        ST_METRIC(_metrics.m.bytesWritten += written);
+        cachePut(key, crc, version, size);
+        
+        ST_LOG(STORAGE_LOG_INFO, "NVS: '%s' saved (version: %d, size: %u, CRC: 0x%08X)", 
+               key, version, (uint32_t)size, crc);
+        return true;
+    }
+
+    /**
+     * Записать отложенные данные слота
+     */
+    bool writePending(ThrottleSlot& slot, uint32_t now) {
+        const uint8_t* raw = slot.pending;
+        uint32_t crc;
+        memcpy(&crc, raw + 4, sizeof(crc));  // Package: version, reserved[3], crc, data
+        if (!writePackage(slot.key, raw, slot.pendingSize, raw[0], crc)) {
+            return false;  // данные остаются отложенными до следующего tick()
+        }
+        slot.lastSaveTime = now;
+        slot.saved = true;
+        dropPending(&slot);
+        return true;
+    }
+
+    /**
+     * Положить готовый пакет в слот до tick() (заменяет прежние отложенные данные).
+     * Буфер берется из статического пула, куча не используется
+     * @return false если в пуле нет свободного буфера нужного размера
+     */
+    bool deferPackage(ThrottleSlot* slot, const void* pkg, size_t size) {
+        if (!slot->pending || poolCapacity(slot->pendingBuf) < size) {
+            dropPending(slot);
+            uint8_t index = poolTake(size);
+            if (index == POOL_BUFFERS) {
+                ST_LOG(STORAGE_LOG_WARNING, "NVS: No free pending buffer for '%s' (%u bytes)", 
+                       slot->key, (uint32_t)size);
+                return false;
+            }
+            slot->pending = poolData(index);
+            slot->pendingBuf = index;
+            _pendingCount++;
+        }
+        slot->pendingSize = size;
+        memcpy(slot->pending, pkg, size);
+        return true;
+    }
+
+    /**
+     * Загрузка пакета другой версии (через цепочку миграций) или другого размера
+     * (при setSizeTolerant: копируется общий префикс, хвост out не меняется).
+     * Результат кладется в отложенную запись - во флеш его запишет tick()/flush().
+     * Вызывать под ScratchGuard
+     * @param key Имя ключа
+     * @param raw Пакет любой версии и размера (в _scratch или отложенный в слоте)
+     * @param len Размер пакета
+     * @param out Куда положить данные текущей версии
+     * @param outSize Размер данных текущей версии
+     * @param version Текущая версия
+     * @param migrations Цепочка миграций (nullptr - только та же версия)
+     * @return true если данные переведены в текущую версию
+     */
+    bool migratePackage(const char* key, const uint8_t* raw, size_t len, void* out, size_t outSize,
+                        uint8_t version, const StorageMigrations* migrations) {
+        if (len < 8 || outSize + 8 > NVS_MAX_SIZE) {
+            ST_LOG(STORAGE_LOG_WARNING, "NVS: Size mismatch or key '%s' not found", key);
+            return false;
+        }
+        if (raw != _scratch) memcpy(_scratch, raw, len);
+        uint8_t stored = _scratch[0];
+        uint32_t storedCrc;
+        memcpy(&storedCrc, _scratch + 4, sizeof(storedCrc));
+        size_t size = len - 8;
+        if (StorageCrc32::calc(_scratch + 8, size) != storedCrc) {
+            ST_LOG(STORAGE_LOG_ERROR, "NVS: CRC error for '%s'", key);
+            ST_METRIC(_metrics.m.crcErrors++);
+            return false;
+        }
+        if (stored != version && (!migrations 
+                || !migrations->apply(_scratch + 8, size, NVS_MAX_SIZE - 8, stored, version))) {
+            ST_LOG(STORAGE_LOG_WARNING, "NVS: Version mismatch for '%s' (stored: %d, expected: %d)", 
+                   key, stored, version);
+            return false;
+        }
+        if (size != outSize && !_sizeTolerant) {
+            ST_LOG(STORAGE_LOG_WARNING, "NVS: Size mismatch for '%s' (stored: %u, expected: %u)", 
+                   key, (uint32_t)size, (uint32_t)outSize);
+            return false;
+        }
+        // Общий префикс; хвост новой, более длинной структуры остается как был (значения по умолчанию)
+        memcpy(out, _scratch + 8, size < outSize ? size : outSize);
+
+        // Обратная запись полной структуры - не сразу, а при ближайшем tick()/flush().
+        // Префикс уже лежит в _scratch, дописываем только хвост выросшей структуры
+        _scratch[0] = version;
+        if (size < outSize) memcpy(_scratch + 8 + size, (const uint8_t*)out + size, outSize - size);
+        uint32_t crc = StorageCrc32::calc(_scratch + 8, outSize);
+        memcpy(_scratch + 4, &crc, sizeof(crc));
+        ThrottleSlot* slot = throttleSlot(key);
+        if (!slot || !deferPackage(slot, _scratch, outSize + 8)) {
+            ST_LOG(STORAGE_LOG_WARNING, "NVS: '%s' converted in RAM only, will convert again on next load", key);
+        }
+        cacheDrop(key);
+        ST_LOG(STORAGE_LOG_INFO, "NVS: '%s' converted v%d (%u bytes) -> v%d (%u bytes)", 
+               key, stored, (uint32_t)size, version, (uint32_t)outSize);
+        return true;
+    }
+
+    /**
+     * Общая часть save(): пропуск неизменных данных, защита от частых записей, запись
+     * @param key Имя ключа
+     * @param pkg Готовый пакет: version (байт 0), reserved, crc (байты 4..7), данные
+     * @param size Размер пакета
+     * @param version Версия
+     * @param crc CRC данных
+     * @param force Игнорировать защиту от частых записей
+     * @return true если записано, отложено или уже лежит во флеше
+     */
+    bool storePackage(const char* key, const void* pkg, size_t size, uint8_t version, uint32_t crc, bool force) {
+#if NVS_CRC_CACHE_SIZE > 0
+        // Данные не изменились с последней загрузки/записи - флеш не трогаем
+        CacheEntry* cached = cacheFind(key);
+        if (cached && cached->crc == crc && cached->version == version && cached->size == size) {
+            ST_LOG(STORAGE_LOG_DEBUG, "NVS: '%s' unchanged, write skipped", key);
+            ST_METRIC(_metrics.m.skipped++);
+            dropPending(findSlot(key));  // отложенная запись устарела - во флеше уже эти данные
+            return true;
+        }
+#endif
+        
+        uint32_t now = millis();
+        ThrottleSlot* slot = throttleSlot(key);
+
+        // Запись ключа ещё рано - откладываем до tick(), последние данные заменяют предыдущие.
+        // Пул отложенных записей занят - пишем сразу, чтобы не потерять данные
+        if (!force && slot && slot->saved && elapsedSince(slot->lastSaveTime, now) < _minSaveInterval
+                && deferPackage(slot, pkg, size)) {
+            ST_METRIC(_metrics.m.throttled++);
+            ST_LOG(STORAGE_LOG_DEBUG, "NVS: Save of '%s' deferred (elapsed: %u ms)", 
+                   key, elapsedSince(slot->lastSaveTime, now));
+            return true;
+        }
+
+        if (!writePackage(key, pkg, size, version, crc)) {
+            return false;
+        }
+        if (slot) {
+            slot->lastSaveTime = now;
+            slot->saved = true;
+            dropPending(slot);
+        }
+        return true;
+    }
+
+    /**
+     * Тип записи NVS, в которую Preferences кладет значение типа V
+     */
+    template <typename V>
+    static constexpr PreferenceType nativeType() {
+        if constexpr (std::is_floating_point<V>::value) return PT_BLOB;
+        else if constexpr (sizeof(V) == 1) return std::is_signed<V>::value ? PT_I8 : PT_U8;
+        else if constexpr (sizeof(V) == 2) return std::is_signed<V>::value ? PT_I16 : PT_U16;
+        else if constexpr (sizeof(V) == 4) return std::is_signed<V>::value ? PT_I32 : PT_U32;
+        else return std::is_signed<V>::value ? PT_I64 : PT_U64;
+    }
+
+    /**
+     * Итог записи в пакетной сессии: ошибка запоминается до endBatch()
+     * @return true если запись прошла
+     */
+    bool batchStep(esp_err_t err, const char* key) {
+        if (err == ESP_OK) return true;
+        _batchOk = false;
+        ST_LOG(STORAGE_LOG_ERROR, "NVS: Batch write of '%s' failed (0x%X)", key, err);
+        return false;
+    }
+
+    /**
+     * Записать блоб (вызывать с открытым неймспейсом). В пакетной сессии - через
+     * дескриптор сессии без коммита, иначе через Preferences (коммит на каждую запись)
+     * @return Сколько байт записано
+     */
+    size_t putBlob(const char* key, const void* data, size_t size) {
+        if (!_batchOpen) return _prefs.putBytes(key, data, size);
+        return batchStep(nvs_set_blob(_batchNvs, key, data, size), key) ? size : 0;
+    }
+
+    /**
+     * Записать значение родной записью NVS в пакетной сессии (типы записей - как у Preferences)
+     */
+    template <typename V>
+    esp_err_t setNative(const char* key, V value) {
+        if constexpr (std::is_floating_point<V>::value) return nvs_set_blob(_batchNvs, key, &value, sizeof(V));
+        else if constexpr (std::is_same<V, bool>::value) return nvs_set_u8(_batchNvs, key, value ? 1 : 0);
+        else if constexpr (sizeof(V) == 1) return std::is_signed<V>::value ? nvs_set_i8(_batchNvs, key, value) : nvs_set_u8(_batchNvs, key, value);
+        else if constexpr (sizeof(V) == 2) return std::is_signed<V>::value ? nvs_set_i16(_batchNvs, key, value) : nvs_set_u16(_batchNvs, key, value);
+        else if constexpr (sizeof(V) == 4) return std::is_signed<V>::value ? nvs_set_i32(_batchNvs, key, value) : nvs_set_u32(_batchNvs, key, value);
+        else return std::is_signed<V>::value ? nvs_set_i64(_batchNvs, key, value) : nvs_set_u64(_batchNvs, key, value);
+    }
+
+    /**
+     * Записать значение родной записью NVS (вызывать с открытым неймспейсом)
+     * @return Сколько байт записано
+     */
+    template <typename V>
+    size_t putNative(const char* key, V value) {
+        if (_batchOpen) return batchStep(setNative(key, value), key) ? sizeof(V) : 0;
+        if constexpr (std::is_same<V, bool>::value) return _prefs.putBool(key, value);
+        else if constexpr (std::is_same<V, float>::value) return _prefs.putFloat(key, value);
+        else if constexpr (std::is_same<V, double>::value) return _prefs.putDouble(key, value);
+        else if constexpr (sizeof(V) == 1) return std::is_signed<V>::value ? _prefs.putChar(key, value) : _prefs.putUChar(key, value);
+        else if constexpr (sizeof(V) == 2) return std::is_signed<V>::value ? _prefs.putShort(key, value) : _prefs.putUShort(key, value);
+        else if constexpr (sizeof(V) == 4) return std::is_signed<V>::value ? _prefs.putInt(key, value) : _prefs.putUInt(key, value);
+        else return std::is_signed<V>::value ? _prefs.putLong64(key, value) : _prefs.putULong64(key, value);
+    }
+
+    /**
+     * Прочитать значение родной записи NVS (тип уже проверен)
+     */
+    template <typename V>
+    V getNative(const char* key) {
+        if constexpr (std::is_same<V, bool>::value) return _prefs.getBool(key);
+        else if constexpr (sizeof(V) == 1) return std::is_signed<V>::value ? (V)_prefs.getChar(key) : (V)_prefs.getUChar(key);
+        else if constexpr (sizeof(V) == 2) return std::is_signed<V>::value ? (V)_prefs.getShort(key) : (V)_prefs.getUShort(key);
+        else if constexpr (sizeof(V) == 4) return std::is_signed<V>::value ? (V)_prefs.getInt(key) : (V)_prefs.getUInt(key);
+        else return std::is_signed<V>::value ? (V)_prefs.getLong64(key) : (V)_prefs.getULong64(key);
+    }
+
+    /**
+     * Открыть неймспейс для одиночной операции.
+     * Внутри пакетной сессии неймспейс уже открыт на запись - повторно не открываем.
+     * @param readOnly Открыть только для чтения
+     * @return true если неймспейс доступен
+     */
+    bool openNs(bool readOnly) {
+        if (_batchOpen) return true;
+        return _prefs.begin(_ns, readOnly);
+    }
+
+    /**
+     * Закрыть неймспейс после одиночной операции (в пакетной сессии - ничего не делает)
+     */
+    void closeNs() {
+        if (!_batchOpen) _prefs.end();
+    }
+
 public:
     /**
      * Конструктор
@@ -32,6 +541,21 @@ public:
      */
     StorageSmallAkaNVS(const char* namespaceName) : _ns(namespaceName) {}
 
+    /**
+     * Деструктор: отложенные сохранения записываются (flush()), буферы возвращаются
+     * в общий пул. Если запись не прошла (нет питания, ошибка NVS), данные теряются -
+     * об этом пишется предупреждение в журнал
+     */
+    ~StorageSmallAkaNVS() {
+        if (hasPending() && !flush()) {
+            ST_LOG(STORAGE_LOG_WARNING, "NVS: '%s' destroyed with %u unsaved pending writes", _ns, _pendingCount);
+        }
+        dropAllSlots();
+    }
+
+    StorageSmallAkaNVS(const StorageSmallAkaNVS&) = delete;
+    StorageSmallAkaNVS& operator=(const StorageSmallAkaNVS&) = delete;
+
        /**
      * Загрузка данных из NVS (без функции сброса)
      * @param key Уникальное имя ключа
@@ -41,37 +565,107 @@ public:
      */
     template <typename T>
     bool load(const char* key, T& data, uint8_t expectedVersion ) {
+        return loadImpl(key, data, expectedVersion, nullptr);
+    }
+
+    /**
+     * Загрузка с миграцией: данные старой версии (в том числе другого размера)
+     * проводятся по цепочке до expectedVersion в RAM, а обратно во флеш
+     * записываются при ближайшем tick()/flush()
+     * @param key Уникальное имя ключа
+     * @param data Ссылка на переменную/структуру
+     * @param expectedVersion Текущая версия данных
+     * @param migrations Цепочка миграций
+     * @return true если данные загружены (или переведены в текущую версию)
+     */
+    template <typename T>
+    bool load(const char* key, T& data, uint8_t expectedVersion, const StorageMigrations& migrations) {
+        return loadImpl(key, data, expectedVersion, &migrations);
+    }
+
+    /**
+     * Загрузка через RTC-копию: после deep sleep данные берутся из RTC-памяти
+     * без чтения NVS, иначе - из NVS, и копия заполняется прочитанным
+     * @param key Уникальное имя ключа
+     * @param data Ссылка на переменную/структуру
+     * @param expectedVersion Ожидаемая версия данных
+     * @param shadow RTC-копия объекта (RTC_NOINIT_ATTR)
+     * @return true если данные загружены из RTC-копии или из NVS
+     */
+    template <typename T, typename C>
+    bool load(const char* key, T& data, uint8_t expectedVersion, StorageRtcShadow<T, C>& shadow) {
+        if (shadow.restore(data)) {
+            ST_LOG(STORAGE_LOG_DEBUG, "NVS: '%s' restored from RTC (%u saves not in flash)", key, shadow.cycles);
+            return true;
+        }
+        if (!loadImpl(key, data, expectedVersion, nullptr)) return false;
+        shadow.adopt(data);
+        return true;
+    }
+
+private:
+    template <typename T>
+    bool loadImpl(const char* key, T& data, uint8_t expectedVersion, const StorageMigrations* migrations) {
+        StorageLockGuard<StorageDefaultLock> guard(_lock);
+        bool convert = migrations || _sizeTolerant;
+        ScratchGuard scratch(usesScratch<T>() || convert);
+        ST_METRIC(StorageMetricTimer timer(_metrics.m.load));
         ST_LOG(STORAGE_LOG_INFO, "NVS: Load '%s'...", key);
+
+        // Есть отложенная запись - она новее, чем данные во флеше
+        ThrottleSlot* slot = findSlot(key);
+        if (slot && slot->pending && (slot->pendingSize == sizeof(Package<T>) || convert)) {
+            const Package<T>* pending = reinterpret_cast<const Package<T>*>(slot->pending);
+            if (convert && (slot->pendingSize != sizeof(Package<T>) || pending->version != expectedVersion)) {
+                return migratePackage(key, slot->pending, slot->pendingSize, &data, sizeof(T),
+                                      expectedVersion, migrations);
+            }
+            if (pending->version != expectedVersion) {
+                ST_LOG(STORAGE_LOG_WARNING, "NVS: Version mismatch for '%s' (stored: %d, expected: %d)", 
+                       key, pending->version, expectedVersion);
+                return false;
+            }
+            memcpy(&data, &pending->data, sizeof(T));
+            ST_LOG(STORAGE_LOG_INFO, "NVS: '%s' loaded from pending save (version: %d)", key, pending->version);
+            return true;
+        }
         
-        if (!_prefs.begin(_ns, true)) {
-            ST_LOG(STORAGE_LOG_ERROR, "NVS: Failed to open namespace '%s'", _ns);
+        if (sizeof(Package<T>) > NVS_MAX_SIZE) {
+            ST_LOG(STORAGE_LOG_ERROR, "NVS: Data too large for '%s'! Max %u bytes, got %u", 
+                   key, NVS_MAX_SIZE, (uint32_t)sizeof(Package<T>));
             return false;
         }
-        
-        
-        //Package<T>* pkg = new (std::nothrow) Package<T>(); // <--- ИСПРАВЛЕНО
-        // Создаем умный указатель в куче. Память очистится сама при любом return.
-        std::unique_ptr<Package<T>> pkg(new (std::nothrow) Package<T>()); 
 
-        if (!pkg) { // <--- ДОБАВЛЕНО (проверка на нехватку оперативной памяти)
-            ST_LOG(STORAGE_LOG_ERROR, "NVS: Out of memory for '%s'", key);
-            _prefs.end();
+        if (!openNs(true)) {
+            ST_LOG(STORAGE_LOG_ERROR, "NVS: Failed to open namespace '%s'", _ns);
             return false;
         }
+        
+        // Без кучи: маленький пакет в стеке, большой в общем статическом буфере.
+        // Данные вызывающего не трогаем, пока не пройдены все проверки.
+        PackageHolder<T> local;
+        Package<T>* pkg = packageBuffer<T>(local);
 
+        // Читаем данные напрямую в буфер пакета. nvs_get_blob не читает запись по частям,
+        // поэтому буфер - на весь пакет. С миграциями размер заранее неизвестен -
+        // одно чтение сразу в общий буфер на NVS_MAX_SIZE
+        size_t len;
+        if (convert) {
+            len = _prefs.getBytes(key, _scratch, NVS_MAX_SIZE);
+            pkg = reinterpret_cast<Package<T>*>(_scratch);
+        } else {
+            len = _prefs.getBytes(key, pkg, sizeof(Package<T>));
+        }
+        closeNs();
 
-
-        //size_t len = _prefs.getBytes(key, &pkg, sizeof(pkg));
-        //size_t len = _prefs.getBytes(key, pkg, sizeof(Package<T>));
-        // Читаем данные напрямую в выделенную область памяти
-        size_t len = _prefs.getBytes(key, pkg.get(), sizeof(Package<T>));
-
-        _prefs.end();
+        if (convert && (len != sizeof(Package<T>) || pkg->version != expectedVersion)) {
+            // Другая версия или размер - переводим прямо в общем буфере
+            return migratePackage(key, _scratch, len, &data, sizeof(T), expectedVersion, migrations);
+        }
 
         // 1. Проверка размера
         if (len != sizeof(Package<T>)) {
             ST_LOG(STORAGE_LOG_WARNING, "NVS: Size mismatch or key '%s' not found", key);
-            //delete pkg;
             return false;
         }
 
@@ -79,25 +673,25 @@ public:
         if (pkg->version != expectedVersion) {
             ST_LOG(STORAGE_LOG_WARNING, "NVS: Version mismatch for '%s' (stored: %d, expected: %d)", 
                    key, pkg->version, expectedVersion);
-            //delete pkg;
             return false;
         }
 
         // 3. Проверка целостности (CRC)
-        uint32_t calcCrc = crc32_le(0, (const uint8_t*)&pkg->data, sizeof(T));
+        uint32_t calcCrc = StorageCrc32::calc(&pkg->data, sizeof(T));
         if (pkg->crc != calcCrc) {
             ST_LOG(STORAGE_LOG_ERROR, "NVS: CRC error for '%s'", key);
-            //delete pkg;
+            ST_METRIC(_metrics.m.crcErrors++);
             return false;
         }
         
         // Если все проверки пройдены, копируем данные
         memcpy(&data, &pkg->data, sizeof(T)); 
+        cachePut(key, calcCrc, pkg->version, sizeof(Package<T>));
         ST_LOG(STORAGE_LOG_INFO, "NVS: '%s' loaded OK (version: %d)", key, pkg->version);
-        //delete pkg;
         return true;
     }
 
+public:
 
     /**
      * Сохранение данных в NVS
@@ -105,71 +699,356 @@ public:
      * @param data Данные для сохранения
      * @param version Версия структуры данных
      * @param force Игнорировать защиту от частых записей
-     * @return true если данные сохранены успешно
+     * @return true если данные сохранены успешно (или уже лежат во флеше без изменений)
      */
     template <typename T>
     bool save(const char* key, const T& data, uint8_t version , bool force = false) {
+        StorageLockGuard<StorageDefaultLock> guard(_lock);
+        ScratchGuard scratch(usesScratch<T>());
         if (sizeof(Package<T>) > NVS_MAX_SIZE) {
             ST_LOG(STORAGE_LOG_ERROR, "NVS: Data too large for '%s'! Max %u bytes, got %u", 
                    key, NVS_MAX_SIZE, (uint32_t)sizeof(Package<T>));
             return false;
         }
+
+        uint32_t crc = StorageCrc32::calc(&data, sizeof(T));
         
-        if (!force) {
-            uint32_t now = millis();
-            uint32_t elapsed = (now >= _lastSaveTime) 
-                ? (now - _lastSaveTime) 
-                : (UINT32_MAX - _lastSaveTime + now);
-                
-            if (elapsed < _minSaveInterval) {
-                ST_LOG(STORAGE_LOG_WARNING, "NVS: Save throttled for '%s' (elapsed: %u ms)", 
-                       key, elapsed);
-                return false;
+        PackageHolder<T> local;
+        Package<T>* pkg = packageBuffer<T>(local);
+
+        pkg->version = version;
+        memset(pkg->reserved, 0, sizeof(pkg->reserved));
+        pkg->crc = crc;
+        memcpy(&pkg->data, &data, sizeof(T));
+
+        return storePackage(key, pkg, sizeof(Package<T>), version, crc, force);
+    }
+
+    /**
+     * Сохранение через RTC-копию: данные всегда попадают в RTC-память,
+     * а в NVS - только раз в writeEvery сохранений с изменениями (сразу, без защиты от частых записей)
+     * @param key Уникальное имя ключа
+     * @param data Данные для сохранения
+     * @param version Версия структуры данных
+     * @param shadow RTC-копия объекта (RTC_NOINIT_ATTR)
+     * @param writeEvery Раз во сколько сохранений писать во флеш
+     * @return true если данные сохранены в RTC-копию (и, если было пора, в NVS)
+     */
+    template <typename T, typename C>
+    bool save(const char* key, const T& data, uint8_t version, StorageRtcShadow<T, C>& shadow,
+              uint16_t writeEvery = STORAGE_RTC_WRITE_EVERY) {
+        if (!shadow.store(data, writeEvery)) {
+            ST_METRIC(_metrics.m.skipped++);
+            return true;
+        }
+        // Без троттлинга: отложенная в RAM запись не переживет deep sleep
+        if (!save(key, data, version, true)) return false;
+        shadow.markWritten();
+        return true;
+    }
+
+    /**
+     * Сохранение простого значения (bool, целые, float, double) родной записью NVS
+     * без заголовка Package: меньше места в странице NVS и быстрее чтение при старте.
+     * Целостность обеспечивает CRC самой записи NVS. Защита от частых записей не действует
+     * @param key Уникальное имя ключа
+     * @param value Значение
+     * @return true если значение сохранено (или уже лежит во флеше без изменений)
+     */
+    template <typename V>
+    bool saveValue(const char* key, V value) {
+        static_assert(std::is_arithmetic<V>::value, "saveValue: only bool, integer, float or double");
+        StorageLockGuard<StorageDefaultLock> guard(_lock);
+        uint32_t crc = StorageCrc32::calc(&value, sizeof(V));
+
+#if NVS_CRC_CACHE_SIZE > 0
+        // Размер пакета всегда больше 8, так что с пакетами под тем же ключом не спутать
+        CacheEntry* cached = cacheFind(key);
+        if (cached && cached->crc == crc && cached->version == 0 && cached->size == sizeof(V)) {
+            ST_LOG(STORAGE_LOG_DEBUG, "NVS: '%s' unchanged, write skipped", key);
+            ST_METRIC(_metrics.m.skipped++);
+            return true;
+        }
+#endif
+        dropPending(findSlot(key));  // отложенный пакет под этим ключом устарел
+
+        if (!openNs(false)) {
+            ST_LOG(STORAGE_LOG_ERROR, "NVS: Failed to open namespace '%s' for write", _ns);
+            return false;
+        }
+        size_t written;
+        {
+            ST_METRIC(StorageMetricTimer timer(_metrics.m.save));
+            written = putNative(key, value);
+        }
+        closeNs();
+
+        if (written != sizeof(V)) {
+            ST_LOG(STORAGE_LOG_ERROR, "NVS: Failed to write value '%s'", key);
+            ST_METRIC(_metrics.m.failures++);
+            cacheDrop(key);
+            return false;
+        }
+        ST_METRIC(_metrics.m.bytesWritten += written);
+        cachePut(key, crc, 0, sizeof(V));
+        ST_LOG(STORAGE_LOG_INFO, "NVS: '%s' saved as native value (size: %u)", key, (uint32_t)sizeof(V));
+        return true;
+    }
+
+    /**
+     * Загрузка простого значения, сохраненного saveValue()
+     * @param key Уникальное имя ключа
+     * @param value Куда положить значение (не меняется при ошибке)
+     * @return true если ключ есть и тип записи совпадает
+     */
+    template <typename V>
+    bool loadValue(const char* key, V& value) {
+        static_assert(std::is_arithmetic<V>::value, "loadValue: only bool, integer, float or double");
+        StorageLockGuard<StorageDefaultLock> guard(_lock);
+        ST_METRIC(StorageMetricTimer timer(_metrics.m.load));
+        if (!openNs(true)) {
+            ST_LOG(STORAGE_LOG_ERROR, "NVS: Failed to open namespace '%s'", _ns);
+            return false;
+        }
+
+        V v;
+        bool ok;
+        if constexpr (std::is_floating_point<V>::value) {
+            ok = _prefs.getBytes(key, &v, sizeof(V)) == sizeof(V);
+        } else {
+            ok = _prefs.getType(key) == nativeType<V>();
+            if (ok) v = getNative<V>(key);
+        }
+        closeNs();
+
+        if (!ok) {
+            ST_LOG(STORAGE_LOG_WARNING, "NVS: Value '%s' not found or type mismatch", key);
+            return false;
+        }
+        value = v;
+        cachePut(key, StorageCrc32::calc(&v, sizeof(V)), 0, sizeof(V));
+        ST_LOG(STORAGE_LOG_INFO, "NVS: '%s' loaded as native value", key);
+        return true;
+    }
+
+    /**
+     * @class Group
+     * @brief Группа мелких значений, которая хранится одним блобом.
+     * Общий заголовок (как у Package: версия + CRC), затем таблица полей
+     * по 2 байта (id, размер) и данные полей подряд.
+     * Поле ищется по id, поэтому новые поля можно добавлять в группу
+     * без потери уже сохраненных
+     * @code
+     * StorageSmallAkaNVS::Group ui;
+     * ui.add(1, cfg.brightness).add(2, cfg.enabled).add(3, cfg.volume);
+     * nvs.loadGroup("ui", ui, 1);   // поля, которых нет во флеше, не меняются
+     * nvs.saveGroup("ui", ui, 1);
+     * @endcode
+     */
+    class Group {
+    private:
+        struct Field {
+            void* ptr;
+            uint8_t id;
+            uint8_t size;
+        };
+        Field _fields[NVS_GROUP_MAX_FIELDS];
+        uint8_t _count = 0;
+        friend class StorageSmallAkaNVS;
+
+    public:
+        /**
+         * Добавить поле в группу
+         * @param id Постоянный номер поля (не менять между прошивками)
+         * @param var Переменная поля (до 255 байт)
+         * @return Ссылка на группу для цепочки add()
+         */
+        template <typename V>
+        Group& add(uint8_t id, V& var) {
+            static_assert(sizeof(V) <= 255, "Group field too large");
+            if (_count >= NVS_GROUP_MAX_FIELDS) {
+                ST_LOG(STORAGE_LOG_ERROR, "NVS: Group is full (max %u fields)", NVS_GROUP_MAX_FIELDS);
+                return *this;
             }
-            _lastSaveTime = now;
+            _fields[_count++] = { (void*)&var, id, (uint8_t)sizeof(V) };
+            return *this;
         }
-        
-        //Package<T> pkg;
-        std::unique_ptr<Package<T>> pkg(new (std::nothrow) Package<T>()); 
 
-        if (!pkg) { // Проверка на случай, если оперативная память совсем кончилась
-            ST_LOG(STORAGE_LOG_ERROR, "NVS: Out of memory for '%s' save", key);
+        /**
+         * Размер блоба группы в байтах
+         */
+        size_t packedSize() const {
+            size_t size = 8 + 2 * _count;
+            for (uint8_t i = 0; i < _count; i++) size += _fields[i].size;
+            return size;
+        }
+    };
+
+    /**
+     * Сохранение группы одной записью NVS (с той же защитой от частых записей, что и save())
+     * @param key Уникальное имя ключа
+     * @param group Группа полей
+     * @param version Версия группы
+     * @param force Игнорировать защиту от частых записей
+     * @return true если группа сохранена (отложена или уже лежит во флеше)
+     */
+    bool saveGroup(const char* key, const Group& group, uint8_t version, bool force = false) {
+        StorageLockGuard<StorageDefaultLock> guard(_lock);
+        ScratchGuard scratch;
+        size_t size = group.packedSize();
+        if (size > NVS_MAX_SIZE) {
+            ST_LOG(STORAGE_LOG_ERROR, "NVS: Group too large for '%s'! Max %u bytes, got %u", 
+                   key, NVS_MAX_SIZE, (uint32_t)size);
             return false;
         }
 
-        pkg->version = version;
-        pkg->crc = crc32_le(0, (const uint8_t*)&data, sizeof(T));
-        memcpy(&pkg->data, &data, sizeof(T));
-        
-        if (!_prefs.begin(_ns, false)) {
-            ST_LOG(STORAGE_LOG_ERROR, "NVS: Failed to open namespace '%s' for write", _ns);
+        // Собираем блоб в общем буфере: [version][count][0][0][crc] [id,size]... [data]...
+        uint8_t* p = _scratch;
+        p[0] = version;
+        p[1] = group._count;
+        p[2] = p[3] = 0;
+        uint8_t* table = p + 8;
+        uint8_t* body = table + 2 * group._count;
+        for (uint8_t i = 0; i < group._count; i++) {
+            table[2 * i] = group._fields[i].id;
+            table[2 * i + 1] = group._fields[i].size;
+            memcpy(body, group._fields[i].ptr, group._fields[i].size);
+            body += group._fields[i].size;
+        }
+        uint32_t crc = StorageCrc32::calc(table, size - 8);
+        memcpy(p + 4, &crc, sizeof(crc));
+
+        return storePackage(key, p, size, version, crc, force);
+    }
+
+    /**
+     * Загрузка группы: поля раскладываются по id. Поля группы, которых нет
+     * в сохраненном блобе (или с другим размером), остаются без изменений
+     * @param key Уникальное имя ключа
+     * @param group Группа полей
+     * @param expectedVersion Ожидаемая версия группы
+     * @return true если блоб найден, версия и CRC совпали
+     */
+    bool loadGroup(const char* key, Group& group, uint8_t expectedVersion) {
+        StorageLockGuard<StorageDefaultLock> guard(_lock);
+        ScratchGuard scratch;
+        ST_METRIC(StorageMetricTimer timer(_metrics.m.load));
+        ST_LOG(STORAGE_LOG_INFO, "NVS: Load group '%s'...", key);
+
+        const uint8_t* p;
+        size_t len;
+        ThrottleSlot* slot = findSlot(key);
+        if (slot && slot->pending) {
+            p = slot->pending;   // отложенная запись новее флеша
+            len = slot->pendingSize;
+        } else {
+            if (!openNs(true)) {
+                ST_LOG(STORAGE_LOG_ERROR, "NVS: Failed to open namespace '%s'", _ns);
+                return false;
+            }
+            len = _prefs.getBytes(key, _scratch, NVS_MAX_SIZE);
+            closeNs();
+            p = _scratch;
+        }
+
+        if (len < 8 || len < 8 + 2 * (size_t)p[1]) {
+            ST_LOG(STORAGE_LOG_WARNING, "NVS: Group '%s' not found or damaged", key);
             return false;
         }
-        
-        //size_t written = _prefs.putBytes(key, &pkg, sizeof(pkg));
-        size_t written = _prefs.putBytes(key, pkg.get(), sizeof(Package<T>));
-        _prefs.end();
-        
-        if (written != sizeof(Package<T>)) {
-            ST_LOG(STORAGE_LOG_ERROR, "NVS: Failed to write key '%s' (written: %u, expected: %u)", 
-                   key, written, (uint32_t)sizeof(Package<T>));
+        if (p[0] != expectedVersion) {
+            ST_LOG(STORAGE_LOG_WARNING, "NVS: Version mismatch for '%s' (stored: %d, expected: %d)", 
+                   key, p[0], expectedVersion);
             return false;
         }
-        
-        ST_LOG(STORAGE_LOG_INFO, "NVS: '%s' saved (version: %d, size: %u, CRC: 0x%08X)", 
-               key, version, (uint32_t)sizeof(Package<T>), pkg->crc);
+        uint32_t storedCrc;
+        memcpy(&storedCrc, p + 4, sizeof(storedCrc));
+        uint32_t crc = StorageCrc32::calc(p + 8, len - 8);
+        if (crc != storedCrc) {
+            ST_LOG(STORAGE_LOG_ERROR, "NVS: CRC error for '%s'", key);
+            ST_METRIC(_metrics.m.crcErrors++);
+            return false;
+        }
+
+        // Проверяем, что таблица описывает ровно len байт, и только потом раскладываем
+        uint8_t count = p[1];
+        const uint8_t* table = p + 8;
+        size_t body = 8 + 2 * count;
+        for (uint8_t i = 0; i < count; i++) body += table[2 * i + 1];
+        if (body != len) {
+            ST_LOG(STORAGE_LOG_ERROR, "NVS: Group '%s' table damaged", key);
+            return false;
+        }
+
+        uint8_t found = 0;
+        const uint8_t* data = table + 2 * count;
+        for (uint8_t i = 0; i < count; i++) {
+            uint8_t id = table[2 * i];
+            uint8_t size = table[2 * i + 1];
+            for (uint8_t j = 0; j < group._count; j++) {
+                if (group._fields[j].id == id && group._fields[j].size == size) {
+                    memcpy(group._fields[j].ptr, data, size);
+                    found++;
+                    break;
+                }
+            }
+            data += size;
+        }
+        if (p == _scratch) cachePut(key, crc, expectedVersion, len);
+        ST_LOG(STORAGE_LOG_INFO, "NVS: Group '%s' loaded OK (version: %d, fields: %u of %u)", 
+               key, expectedVersion, found, group._count);
         return true;
     }
 
+    /**
+     * Дописать отложенные (задушенные) сохранения, у которых истёк интервал.
+     * Вызывать в loop(), как StorageBigAkaFileSys::tick()
+     */
+    void tick() {
+        if (!_pendingCount) return;
+        StorageLockGuard<StorageDefaultLock> guard(_lock);
+        uint32_t now = millis();
+        for (uint8_t i = 0; i < NVS_THROTTLE_SLOTS; i++) {
+            ThrottleSlot& slot = _slots[i];
+            if (slot.pending && elapsedSince(slot.lastSaveTime, now) >= _minSaveInterval) {
+                writePending(slot, now);
+            }
+        }
+    }
+
+    /**
+     * Немедленно записать все отложенные сохранения, не дожидаясь интервала
+     * @return true если все отложенные данные записаны
+     */
+    bool flush() {
+        StorageLockGuard<StorageDefaultLock> guard(_lock);
+        bool ok = true;
+        uint32_t now = millis();
+        for (uint8_t i = 0; i < NVS_THROTTLE_SLOTS; i++) {
+            if (_slots[i].pending) ok &= writePending(_slots[i], now);
+        }
+        return ok;
+    }
+
+    /**
+     * Есть ли отложенные сохранения
+     * @return true если есть данные, ожидающие записи в tick()
+     */
+    bool hasPending() const {
+        return _pendingCount > 0;
+    }
+
     /**
      * Проверка наличия ключа
      * @param key Имя ключа
      * @return true если ключ существует
      */
     bool exists(const char* key) {
-        if (!_prefs.begin(_ns, true)) return false;
+        StorageLockGuard<StorageDefaultLock> guard(_lock);
+        ThrottleSlot* slot = findSlot(key);
+        if (slot && slot->pending) return true;
+        if (!openNs(true)) return false;
         bool keyExists = _prefs.isKey(key);
-        _prefs.end();
+        closeNs();
         ST_LOG(STORAGE_LOG_DEBUG, "NVS: Key '%s' exists: %s", key, keyExists ? "yes" : "no");
         return keyExists;
     }
@@ -180,9 +1059,19 @@ public:
      * @return true если ключ удалён успешно
      */
     bool remove(const char* key) {
-        if (!_prefs.begin(_ns, false)) return false;
-        bool success = _prefs.remove(key);
-        _prefs.end();
+        StorageLockGuard<StorageDefaultLock> guard(_lock);
+        if (!openNs(false)) return false;
+        bool success;
+        if (_batchOpen) {
+            esp_err_t err = nvs_erase_key(_batchNvs, key);
+            success = err == ESP_OK;
+            if (err != ESP_ERR_NVS_NOT_FOUND) batchStep(err, key);
+        } else {
+            success = _prefs.remove(key);
+        }
+        closeNs();
+        cacheDrop(key);
+        dropPending(findSlot(key));
         if (success) {
             ST_LOG(STORAGE_LOG_INFO, "NVS: Key '%s' removed", key);
         } else {
@@ -192,7 +1081,106 @@ public:
     }
 
     /**
-     * Установить минимальный интервал между записями
+     * Начать пакетную сессию: неймспейс открывается один раз и остается открытым
+     * для всех load/save/exists/remove до endBatch(). Записи сессии идут через один
+     * дескриптор NVS без коммита на каждую, nvs_commit() - один раз в endBatch().
+     * Вызовы можно вкладывать - сессия закроется на последнем endBatch().
+     * С STORAGE_THREAD_SAFE сессия держит блокировку этого объекта до endBatch():
+     * другие задачи ждут на его load/save, остальные объекты NVS не блокируются.
+     * @return true если неймспейс открыт
+     */
+    bool beginBatch() {
+        _lock.lock();
+        if (_batchDepth > 0) {
+            _batchDepth++;
+            return _batchOpen;
+        }
+        esp_err_t err = nvs_open(_ns, NVS_READWRITE, &_batchNvs);
+        if (err != ESP_OK || !_prefs.begin(_ns, true)) {
+            ST_LOG(STORAGE_LOG_ERROR, "NVS: Failed to open namespace '%s' for batch (0x%X)", _ns, err);
+            if (err == ESP_OK) nvs_close(_batchNvs);
+            _lock.unlock();
+            return false;
+        }
+        _batchDepth = 1;
+        _batchOpen = true;
+        _batchOk = true;
+        ST_LOG(STORAGE_LOG_DEBUG, "NVS: Batch started for '%s'", _ns);
+        return true;
+    }
+
+    /**
+     * Завершить пакетную сессию. На внешнем уровне вложенности фиксирует записи
+     * (nvs_commit) и закрывает неймспейс
+     * @return true если все записи сессии и коммит прошли (на вложенном уровне - записи до этого момента)
+     */
+    bool endBatch() {
+        if (_batchDepth == 0) return false;
+        bool ok = _batchOk;
+        if (--_batchDepth == 0) {
+            esp_err_t err = nvs_commit(_batchNvs);
+            if (err != ESP_OK) {
+                ok = false;
+                ST_LOG(STORAGE_LOG_ERROR, "NVS: Batch commit for '%s' failed (0x%X)", _ns, err);
+            }
+            nvs_close(_batchNvs);
+            _prefs.end();
+            _batchOpen = false;
+            ST_LOG(STORAGE_LOG_DEBUG, "NVS: Batch finished for '%s'", _ns);
+        }
+        _lock.unlock();
+        return ok;
+    }
+
+    /**
+     * Проверка активной пакетной сессии
+     * @return true если неймспейс удерживается открытым
+     */
+    bool inBatch() const {
+        return _batchOpen;
+    }
+
+    /**
+     * @class Batch
+     * @brief RAII-обертка над beginBatch()/endBatch()
+     * @code
+     * {
+     *     StorageSmallAkaNVS::Batch batch(nvs);
+     *     nvs.load("wifi", wifiCfg, 1);
+     *     nvs.load("mqtt", mqttCfg, 1);
+     * } // неймспейс закрыт здесь
+     * @endcode
+     */
+    class Batch {
+    private:
+        StorageSmallAkaNVS& _owner;
+        bool _ok;
+        bool _ended = false;
+    public:
+        explicit Batch(StorageSmallAkaNVS& owner) : _owner(owner), _ok(owner.beginBatch()) {}
+        ~Batch() { end(); }
+        Batch(const Batch&) = delete;
+        Batch& operator=(const Batch&) = delete;
+
+        /**
+         * @return true если сессия открыта успешно
+         */
+        bool ok() const { return _ok; }
+
+        /**
+         * Завершить сессию до выхода из области видимости
+         * @return Результат endBatch() (false если сессия не открылась или уже завершена)
+         */
+        bool end() {
+            if (!_ok || _ended) return false;
+            _ended = true;
+            return _owner.endBatch();
+        }
+    };
+
+    /**
+     * Установить минимальный интервал между записями одного ключа.
+     * Более частые save() не теряются, а откладываются до tick()
      * @param ms Интервал в миллисекундах
      */
     void setMinSaveInterval(uint32_t ms) {
@@ -200,17 +1188,54 @@ public:
         ST_LOG(STORAGE_LOG_DEBUG, "NVS: Min save interval set to %u ms", ms);
     }
 
+    /**
+     * Загрузка при изменившемся размере структуры: если сохранено меньше или больше
+     * байт, чем sizeof(T), load() берет общий префикс, а хвост data оставляет как есть
+     * (заполни data значениями по умолчанию до load()). Полная структура записывается
+     * обратно при ближайшем tick()/flush(). Подходит, когда поля только дописываются в конец
+     * @param enabled true для загрузки общего префикса
+     */
+    void setSizeTolerant(bool enabled) {
+        _sizeTolerant = enabled;
+        ST_LOG(STORAGE_LOG_DEBUG, "NVS: Size tolerant load for '%s' %s", _ns, enabled ? "enabled" : "disabled");
+    }
+
+    /**
+     * Сбросить RAM-кэш CRC (нужно, если неймспейс менялся в обход этого объекта)
+     */
+    void invalidateCache() {
+        StorageLockGuard<StorageDefaultLock> guard(_lock);
+        cacheClear();
+        ST_LOG(STORAGE_LOG_DEBUG, "NVS: CRC cache for '%s' invalidated", _ns);
+    }
+
+#ifdef STORAGE_METRICS
+    /**
+     * Счетчики неймспейса (-D STORAGE_METRICS)
+     */
+    const StorageMetrics& getMetrics() const { return _metrics.m; }
+
+    /**
+     * Обнулить счетчики неймспейса
+     */
+    void resetMetrics() { _metrics.m = StorageMetrics(); }
+#endif
+
     /**
      * Удалить все ключи в текущем пространстве имен
      * @return true если очистка прошла успешно
      */
     bool clearNamespace() {
-        if (!_prefs.begin(_ns, false)) {
+        StorageLockGuard<StorageDefaultLock> guard(_lock);
+        if (!openNs(false)) {
             ST_LOG(STORAGE_LOG_ERROR, "NVS: Failed to open '%s' for clear", _ns);
             return false;
         }
-        bool success = _prefs.clear(); // Удаляет все пары ключ-значение в этом namespace
-        _prefs.end();
+        // Удаляет все пары ключ-значение в этом namespace
+        bool success = _batchOpen ? batchStep(nvs_erase_all(_batchNvs), "*") : _prefs.clear();
+        closeNs();
+        cacheClear();
+        dropAllSlots();
         
         if (success) {
             ST_LOG(STORAGE_LOG_INFO, "NVS: Namespace '%s' cleared", _ns);
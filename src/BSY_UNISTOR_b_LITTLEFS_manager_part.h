@@ -0,0 +1,652 @@
+#ifndef BSY_UNISTOR_B_LITTLEFS_MANAGER_PART_H
+#define BSY_UNISTOR_B_LITTLEFS_MANAGER_PART_H
+
+#include <esp_system.h>
+#include <esp_timer.h>
+
+    class StorageManager;
+
+    /**
+     * @class StorageManagedFile
+     * @brief Общая (не шаблонная) часть файловых хранилищ: узел реестра StorageManager.
+     * Каждый StorageBigAkaFileSys при создании сам встаёт в реестр
+     */
+    class StorageManagedFile {
+    private:
+        StorageManagedFile* _next = nullptr;
+        uint8_t _priority = 0;
+        uint32_t _pass = 0;     // номер окна записи, в котором объект уже обработан
+        uint32_t _writeUs = 0;  // сглаженное время записи, мкс (0 - ещё не писался)
+        uint32_t _writeBytes = 0;
+        friend class StorageManager;
+
+        /**
+         * Запустить запись (в фоне, если она включена у объекта)
+         */
+        virtual void requestSave() = 0;
+
+        /**
+         * Сколько байт запишет ближайший save() (оценка для бюджета записи)
+         */
+        virtual size_t pendingBytes() const = 0;
+
+        /**
+         * Загрузить объект, если он ждет ленивой загрузки
+         * @return true если файл прочитан сейчас
+         */
+        virtual bool prefetch() = 0;
+
+        /**
+         * Есть ли данные, которых нет во флеше: изменения или RTC-копия новее файла
+         */
+        virtual bool unflushed() const = 0;
+
+        /**
+         * Записать во флеш сейчас, минуя RTC-копию (writeThrough): после включения
+         * питания или brownout RTC-памяти не верят
+         * @return true если во флеше не осталось устаревших данных
+         */
+        virtual bool flushToFlash() = 0;
+
+    protected:
+        bool _prefetch = false;   // в списке фоновой предзагрузки (loadLazy)
+
+        /**
+         * Учесть время записи (вызывает save() после успешной записи)
+         * @param us Сколько длилась запись
+         * @param bytes Сколько байт данных было к записи
+         */
+        void noteWrite(uint32_t us, size_t bytes);
+
+        StorageManagedFile();
+        ~StorageManagedFile();
+        StorageManagedFile(const StorageManagedFile&) = delete;
+        StorageManagedFile& operator=(const StorageManagedFile&) = delete;
+
+    public:
+        virtual void tick() = 0;
+        virtual bool flush() = 0;
+        virtual bool isDirty() const = 0;
+        virtual const char* getPath() const = 0;
+
+        /**
+         * Момент (millis), когда истекает дебаунс текущих изменений
+         */
+        virtual uint32_t deadline() const = 0;
+
+        /**
+         * Приоритет объекта для StorageManager::flushAll(minPriority): больше - важнее
+         * @param priority 0..255 (по умолчанию 0)
+         */
+        void setPriority(uint8_t priority) { _priority = priority; }
+
+        uint8_t getPriority() const { return _priority; }
+
+        /**
+         * Оценка времени ближайшей записи, мкс: по измеренным записям объекта,
+         * а до первой записи - по средней скорости всех файлов
+         */
+        uint32_t estimateWriteUs() const;
+    };
+
+    /**
+     * @class StorageManager
+     * @brief Реестр всех StorageBigAkaFileSys: один tick() на всех, общий flushAll()
+     * и однократное монтирование LittleFS.
+     *
+     * tick() помнит ближайший срок записи, поэтому пока ничего не пора писать,
+     * он стоит O(1) независимо от числа объектов.
+     *
+     * Когда срок наступил, tick() открывает одно окно записи: вместе с просроченными
+     * пишутся файлы, чей срок наступит в ближайшие STORAGE_FS_COALESCE_MS, от важных
+     * к остальным и от маленьких к большим. Бюджет записи (setBandwidth) ограничивает
+     * средний поток байт во флеш: что не поместилось, переносится в следующее окно.
+     */
+    class StorageManager {
+    private:
+        inline static StorageManagedFile* _head = nullptr;
+        inline static uint32_t _nextDeadline = 0;
+        inline static bool _armed = false;          // есть объекты с изменениями
+        inline static bool _mounted = false;
+        inline static bool _mountTried = false;
+        inline static portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+
+        inline static uint32_t _pass = 0;
+        inline static uint32_t _coalesceMs = STORAGE_FS_COALESCE_MS;
+        inline static uint32_t _bandwidth = STORAGE_FS_BANDWIDTH;   // байт/с, 0 - без ограничения
+        inline static uint32_t _burst = STORAGE_FS_BURST;
+        inline static int32_t _tokens = STORAGE_FS_BURST;           // может уйти в минус после большого файла
+        inline static uint32_t _lastRefill = 0;
+        inline static uint32_t _throttleUntil = 0;
+
+        // Кэш статистики LittleFS: usedBytes() обходит аллокатор блоков, поэтому
+        // между пересчетами занятое место корректируется по записям библиотеки
+        inline static size_t _statTotal = 0;
+        inline static size_t _statUsed = 0;
+        inline static bool _statValid = false;
+        inline static uint32_t _statTime = 0;
+
+        // Средняя скорость записи файлов (для объектов, которые ещё не писались)
+        inline static uint32_t _writeUsPerKb = STORAGE_FS_WRITE_US_PER_KB;
+
+        inline static uint32_t _shutdownBudget = 0;   // flushOnShutdown(): 0 - не зарегистрирован
+        inline static uint8_t _shutdownPriority = 0;
+
+        inline static volatile bool _otaRunning = false;
+        inline static uint32_t _otaDeferred = 0;    // сколько save() отложено до конца OTA
+
+        /**
+         * Пополнить бюджет записи за прошедшее время
+         */
+        static void refill(uint32_t now) {
+            uint64_t add = (uint64_t)(now - _lastRefill) * _bandwidth / 1000;
+            if (!add) return;   // не сдвигаем _lastRefill, чтобы не терять доли байта
+            _lastRefill = now;
+            int64_t tokens = (int64_t)_tokens + add;
+            _tokens = tokens > (int64_t)_burst ? (int32_t)_burst : (int32_t)tokens;
+        }
+
+        /**
+         * Следующий объект окна записи: срок до horizon, ещё не обработан в этом окне;
+         * сначала больший приоритет, при равном - меньший объём, затем более ранний срок
+         */
+        static StorageManagedFile* pickNext(uint32_t horizon, size_t& bytes) {
+            StorageManagedFile* best = nullptr;
+            for (StorageManagedFile* f = _head; f; f = f->_next) {
+                if (f->_pass == _pass || !f->isDirty() || before(horizon, f->deadline())) continue;
+                size_t b = f->pendingBytes();
+                if (!best || f->_priority > best->_priority
+                        || (f->_priority == best->_priority && b < bytes)
+                        || (f->_priority == best->_priority && b == bytes
+                            && before(f->deadline(), best->deadline()))) {
+                    best = f;
+                    bytes = b;
+                }
+            }
+            return best;
+        }
+
+        static size_t roundBlocks(size_t bytes) {
+            return (bytes + STORAGE_FS_BLOCK - 1) / STORAGE_FS_BLOCK * STORAGE_FS_BLOCK;
+        }
+
+        static bool before(uint32_t a, uint32_t b) {
+            return (int32_t)(a - b) < 0;
+        }
+
+        static void shutdownHandler() {
+            if (_shutdownBudget) flushCritical(_shutdownBudget, _shutdownPriority);
+        }
+
+        /**
+         * Пересчитать ближайший срок по всем объектам с изменениями
+         */
+        static void rearm() {
+            bool armed = false;
+            uint32_t next = 0;
+            for (StorageManagedFile* f = _head; f; f = f->_next) {
+                if (!f->isDirty()) continue;
+                uint32_t d = f->deadline();
+                if (!armed || before(d, next)) next = d;
+                armed = true;
+            }
+            portENTER_CRITICAL(&_mux);
+            _nextDeadline = next;
+            _armed = armed;
+            portEXIT_CRITICAL(&_mux);
+        }
+
+    public:
+        static void attach(StorageManagedFile* f) {
+            f->_next = _head;
+            _head = f;
+        }
+
+        static void detach(StorageManagedFile* f) {
+            for (StorageManagedFile** p = &_head; *p; p = &(*p)->_next) {
+                if (*p == f) {
+                    *p = f->_next;
+                    return;
+                }
+            }
+        }
+
+        /**
+         * Сообщить о новом сроке записи (вызывается из update() объектов)
+         * @param deadline Момент (millis), когда объект пора писать
+         */
+        static void schedule(uint32_t deadline) {
+            portENTER_CRITICAL(&_mux);
+            if (!_armed || before(deadline, _nextDeadline)) _nextDeadline = deadline;
+            _armed = true;
+            portEXIT_CRITICAL(&_mux);
+        }
+
+        /**
+         * Один вызов в loop() вместо tick() каждого объекта
+         */
+        static void tick() {
+            if (!_armed) return;
+    #ifdef STORAGE_CHECK_OTA
+            if (_otaRunning) return;    // всё накопленное запишет setOtaRunning(false)
+    #endif
+            uint32_t now = millis();
+            if (before(now, _nextDeadline)) return;
+            if (_bandwidth && before(now, _throttleUntil)) return;
+
+            if (_bandwidth) refill(now);
+            _pass++;
+            uint32_t horizon = now + _coalesceMs;
+            uint32_t files = 0;
+            size_t total = 0;
+            bool throttled = false;
+            size_t bytes = 0;
+            while (StorageManagedFile* f = pickNext(horizon, bytes)) {
+                if (_bandwidth && _tokens <= 0) {
+                    throttled = true;
+                    break;
+                }
+                f->_pass = _pass;
+                if (_bandwidth) _tokens -= (int32_t)bytes;
+                f->requestSave();
+                files++;
+                total += bytes;
+            }
+
+            if (throttled) {
+                // Ждём, пока бюджет снова станет положительным
+                _throttleUntil = now + (uint32_t)(((uint64_t)(1 - _tokens) * 1000 + _bandwidth - 1) / _bandwidth);
+                ST_LOG(STORAGE_LOG_DEBUG, "FS: Write budget exhausted, next window in %u ms", _throttleUntil - now);
+            }
+            if (files) {
+                ST_LOG(STORAGE_LOG_DEBUG, "FS: Write window: %u files, %u bytes", files, total);
+            }
+            rearm();
+        }
+
+        /**
+         * Окно объединения записей: файлы, срок которых наступит в пределах окна,
+         * пишутся вместе с уже просроченными (0 - только просроченные)
+         * @param ms Ширина окна в миллисекундах
+         */
+        static void setCoalesceWindow(uint32_t ms) {
+            _coalesceMs = ms;
+        }
+
+        /**
+         * Бюджет записи файлов через StorageManager::tick().
+         * flushAll() и прямые save()/flush() бюджет не ограничивает
+         * @param bytesPerSec Средний поток байт/с (0 - без ограничения)
+         * @param burst Сколько байт можно записать разом после простоя
+         */
+        static void setBandwidth(uint32_t bytesPerSec, uint32_t burst = STORAGE_FS_BURST) {
+            _bandwidth = bytesPerSec;
+            _burst = burst;
+            _tokens = (int32_t)burst;
+            _lastRefill = millis();
+            _throttleUntil = _lastRefill;
+            ST_LOG(STORAGE_LOG_INFO, "FS: Write budget %u bytes/s (burst: %u)", bytesPerSec, burst);
+        }
+
+        /**
+         * Записать объекты с изменениями и приоритетом не ниже заданного,
+         * начиная с самых важных (перед перезагрузкой, OTA и т.п.).
+         * Объекты с RTC-копией пишутся во флеш, даже если не набрали writeEvery
+         * @param minPriority Минимальный приоритет (0 - все объекты)
+         * @param budgetMs Ограничение по времени: после его исчерпания новые записи
+         * не начинаются (0 - без ограничения)
+         * @return true если все выбранные объекты записаны
+         */
+        static bool flushAll(uint8_t minPriority = 0, uint32_t budgetMs = 0) {
+            bool ok = true;
+            uint32_t start = millis();
+            int level = 255;
+            while (level >= minPriority) {
+                // Следующий по важности уровень среди ещё не записанных
+                int next = -1;
+                for (StorageManagedFile* f = _head; f; f = f->_next) {
+                    if (!f->unflushed() || f->_priority < minPriority) continue;
+                    if (f->_priority == level) {
+                        if (budgetMs && millis() - start >= budgetMs) {
+                            ST_LOG(STORAGE_LOG_WARNING, "FS: Flush budget %u ms exceeded, '%s' left dirty",
+                                budgetMs, f->getPath());
+                            ok = false;
+                            continue;
+                        }
+                        ok &= f->flushToFlash();
+                    } else if (f->_priority < level && f->_priority > next) {
+                        next = f->_priority;
+                    }
+                }
+                level = next;
+            }
+            rearm();
+            ST_LOG(STORAGE_LOG_INFO, "FS: Flush all (min priority: %u) %s", minPriority, ok ? "OK" : "with errors");
+            return ok;
+        }
+
+        /**
+         * Запись самого важного за ограниченное время (просадка питания, перезагрузка).
+         * Объекты идут от важных к остальным, при равном приоритете - от быстрых к медленным;
+         * объект, чья оценка времени записи (estimateWriteUs) не влезает в остаток бюджета,
+         * пропускается, и время достается следующим. Пишет сразу, в вызывающей задаче,
+         * и всегда во флеш: RTC-копия (setRtcShadow) после brownout не действует
+         * @param budgetMs Бюджет времени
+         * @param minPriority Минимальный приоритет (0 - все объекты)
+         * @return true если записаны все объекты с изменениями и приоритетом не ниже minPriority
+         */
+        static bool flushCritical(uint32_t budgetMs, uint8_t minPriority = 0) {
+            int64_t start = esp_timer_get_time();
+            int64_t budgetUs = (int64_t)budgetMs * 1000;
+            uint32_t files = 0;
+            _pass++;
+            while (true) {
+                int64_t left = budgetUs - (esp_timer_get_time() - start);
+                StorageManagedFile* best = nullptr;
+                uint32_t bestUs = 0;
+                for (StorageManagedFile* f = _head; f; f = f->_next) {
+                    if (f->_pass == _pass || !f->unflushed() || f->_priority < minPriority) continue;
+                    uint32_t us = f->estimateWriteUs();
+                    if ((int64_t)us > left) continue;
+                    if (!best || f->_priority > best->_priority
+                            || (f->_priority == best->_priority && us < bestUs)) {
+                        best = f;
+                        bestUs = us;
+                    }
+                }
+                if (!best) break;
+                best->_pass = _pass;
+                if (best->flushToFlash()) files++;
+            }
+
+            uint32_t left = 0;
+            for (StorageManagedFile* f = _head; f; f = f->_next) {
+                if (f->unflushed() && f->_priority >= minPriority) {
+                    ST_LOG(STORAGE_LOG_WARNING, "FS: '%s' left dirty (estimate %u us)", f->getPath(), f->estimateWriteUs());
+                    left++;
+                }
+            }
+            rearm();
+            ST_LOG(STORAGE_LOG_INFO, "FS: Critical flush: %u files in %u ms, %u left", files,
+                (uint32_t)((esp_timer_get_time() - start) / 1000), left);
+            return left == 0;
+        }
+
+        /**
+         * flushCritical() при каждом esp_restart() (и ESP.restart()) через
+         * esp_register_shutdown_handler. При brownout обработчики не вызываются -
+         * по сигналу просадки питания вызывать flushCritical() самому
+         * @param budgetMs Бюджет времени (0 - отменить)
+         * @param minPriority Минимальный приоритет
+         * @return true если обработчик зарегистрирован (или снят при budgetMs = 0)
+         */
+        static bool flushOnShutdown(uint32_t budgetMs = STORAGE_FS_SHUTDOWN_MS, uint8_t minPriority = 0) {
+            bool registered = _shutdownBudget != 0;
+            _shutdownPriority = minPriority;
+            _shutdownBudget = budgetMs;
+            if (!budgetMs) {
+                return !registered || esp_unregister_shutdown_handler(shutdownHandler) == ESP_OK;
+            }
+            if (registered) return true;
+            if (esp_register_shutdown_handler(shutdownHandler) != ESP_OK) {
+                _shutdownBudget = 0;
+                ST_LOG(STORAGE_LOG_ERROR, "FS: Failed to register shutdown handler");
+                return false;
+            }
+            return true;
+        }
+
+        /**
+         * Учесть время записи в средней скорости (вызывает StorageManagedFile::noteWrite())
+         */
+        static void noteWriteRate(uint32_t us, size_t bytes) {
+            if (!bytes) return;
+            uint32_t perKb = (uint32_t)((uint64_t)us * 1024 / bytes);
+            _writeUsPerKb = _writeUsPerKb - _writeUsPerKb / 4 + perKb / 4;
+        }
+
+        /**
+         * @return Средняя скорость записи файлов, мкс на КБ
+         */
+        static uint32_t writeUsPerKb() {
+            return _writeUsPerKb;
+        }
+
+        /**
+         * Загрузить сейчас все объекты из списка предзагрузки (loadLazy(..., true)),
+         * которые ещё не загружены, от важных к остальным
+         * @return Сколько файлов прочитано
+         */
+        static uint32_t prefetchAll() {
+            uint32_t loaded = 0;
+            int level = 255;
+            while (level >= 0) {
+                int next = -1;
+                for (StorageManagedFile* f = _head; f; f = f->_next) {
+                    if (!f->_prefetch) continue;
+                    if (f->_priority == level) {
+                        if (f->prefetch()) loaded++;
+                    } else if (f->_priority < level && f->_priority > next) {
+                        next = f->_priority;
+                    }
+                }
+                level = next;
+            }
+            ST_LOG(STORAGE_LOG_INFO, "FS: Prefetch done (%u files)", loaded);
+            return loaded;
+        }
+
+        /**
+         * Предзагрузка в задаче StorageWriter: setup() не ждет чтения файлов,
+         * а обращение к ещё не загруженному объекту дождется его загрузки.
+         * Задача запускается с настройками по умолчанию, если ещё не запущена
+         * @return true если задание поставлено в очередь
+         */
+        static bool startPrefetch() {
+            if (!StorageWriter::begin()) return false;
+            return StorageWriter::enqueue(nullptr, [](void*) {
+                prefetchAll();
+                return true;
+            });
+        }
+
+        /**
+         * Начало/конец OTA для всех файловых хранилищ.
+         * true: сначала за ограниченное время пишет изменения (от важных к остальным),
+         * затем запись файлов откладывается - данные остаются в RAM помеченными.
+         * false: снимает запрет и сразу дописывает всё накопленное.
+         * Вызывать и при успешном окончании OTA (до перезагрузки), и при ошибке
+         * @param state true если начинается OTA обновление
+         * @param flushBudgetMs Время на запись перед OTA
+         */
+        static void setOtaRunning(bool state, uint32_t flushBudgetMs = STORAGE_OTA_FLUSH_MS) {
+            if (state == _otaRunning) return;
+            if (state) {
+                uint32_t start = millis();
+                flushAll(0, flushBudgetMs);
+                // Дать фоновому писателю закончить начатое, пока флеш ещё наш
+                uint32_t spent = millis() - start;
+                if (StorageWriter::isRunning() && spent < flushBudgetMs) {
+                    StorageWriter::waitIdle(flushBudgetMs - spent);
+                }
+                _otaDeferred = 0;
+                _otaRunning = true;
+                ST_LOG(STORAGE_LOG_INFO, "FS: OTA started, file saves deferred");
+            } else {
+                _otaRunning = false;
+                ST_LOG(STORAGE_LOG_INFO, "FS: OTA finished (%u saves deferred), writing changes", _otaDeferred);
+                _otaDeferred = 0;
+                flushAll();
+            }
+        }
+
+        /**
+         * @return true если выполняется OTA обновление
+         */
+        static bool isOtaRunning() {
+            return _otaRunning;
+        }
+
+        /**
+         * Отметить save(), отложенный до конца OTA (вызывает StorageBigAkaFileSys::save())
+         */
+        static void deferForOta(const char* path) {
+            portENTER_CRITICAL(&_mux);
+            _otaDeferred++;
+            portEXIT_CRITICAL(&_mux);
+            ST_LOG(STORAGE_LOG_DEBUG, "FS: Save of '%s' deferred until OTA ends", path);
+        }
+
+        /**
+         * Обход всех зарегистрированных объектов
+         * @param fn Обработчик
+         * @param ctx Произвольный указатель, передаётся в обработчик
+         */
+        static void forEach(void (*fn)(StorageManagedFile& f, void* ctx), void* ctx = nullptr) {
+            for (StorageManagedFile* f = _head; f; f = f->_next) fn(*f, ctx);
+        }
+
+        /**
+         * @return true если хоть один объект ждёт записи
+         */
+        static bool hasDirty() {
+            for (StorageManagedFile* f = _head; f; f = f->_next) {
+                if (f->isDirty()) return true;
+            }
+            return false;
+        }
+
+        /**
+         * Пересчитать статистику LittleFS (totalBytes/usedBytes)
+         */
+        static void refreshStats() {
+            size_t total = LittleFS.totalBytes();
+            size_t used = LittleFS.usedBytes();
+            portENTER_CRITICAL(&_mux);
+            _statTotal = total;
+            _statUsed = used;
+            _statTime = millis();
+            _statValid = true;
+            portEXIT_CRITICAL(&_mux);
+        }
+
+        /**
+         * Сбросить кэш статистики (после операций в обход библиотеки: format и т.п.)
+         */
+        static void invalidateStats() {
+            _statValid = false;
+        }
+
+        /**
+         * @return true если кэш статистики заполнен (учет записей имеет смысл)
+         */
+        static bool statsValid() {
+            return _statValid;
+        }
+
+        /**
+         * Статистика из кэша; пересчитывается, если кэш пуст или старше STORAGE_FS_STATS_MS
+         */
+        static void fsStats(size_t& total, size_t& used) {
+            if (!_statValid || (STORAGE_FS_STATS_MS && millis() - _statTime >= STORAGE_FS_STATS_MS)) {
+                refreshStats();
+            }
+            portENTER_CRITICAL(&_mux);
+            total = _statTotal;
+            used = _statUsed;
+            portEXIT_CRITICAL(&_mux);
+        }
+
+        /**
+         * Свободное место по кэшу статистики
+         */
+        static size_t freeSpace() {
+            size_t total, used;
+            fsStats(total, used);
+            return total > used ? total - used : 0;
+        }
+
+        /**
+         * Учесть изменение размера файла, записанного библиотекой (с точностью до блока)
+         * @param oldSize Размер до записи (0 - файла не было)
+         * @param newSize Размер после записи (0 - файл удалён)
+         */
+        static void noteFileSize(size_t oldSize, size_t newSize) {
+            if (!_statValid) return;
+            size_t add = roundBlocks(newSize), sub = roundBlocks(oldSize);
+            portENTER_CRITICAL(&_mux);
+            size_t used = _statUsed + add;
+            _statUsed = used > sub ? used - sub : 0;
+            if (_statUsed > _statTotal) _statUsed = _statTotal;
+            portEXIT_CRITICAL(&_mux);
+        }
+
+        static constexpr size_t UNKNOWN_SIZE = SIZE_MAX;  // размер файла не запомнен - нужен запрос к LittleFS
+
+        /**
+         * Размер файла (0 - файла нет). Три обращения к LittleFS (exists/open/close) -
+         * объекты хранилищ запоминают размер своего файла и зовут это только при UNKNOWN_SIZE
+         */
+        static size_t fileSize(const char* path) {
+            if (!LittleFS.exists(path)) return 0;
+            File f = LittleFS.open(path, "r");
+            if (!f) return 0;
+            size_t size = f.size();
+            f.close();
+            return size;
+        }
+
+        /**
+         * Удалить файл с учетом в кэше статистики
+         * @param knownSize Размер файла, если известен (иначе запрашивается у LittleFS)
+         * @return true если файл удалён
+         */
+        static bool removeFile(const char* path, size_t knownSize = UNKNOWN_SIZE) {
+            size_t size = !_statValid ? 0 : (knownSize != UNKNOWN_SIZE ? knownSize : fileSize(path));
+            if (!LittleFS.remove(path)) return false;
+            noteFileSize(size, 0);
+            return true;
+        }
+
+        /**
+         * Смонтирована ли LittleFS. Если StorageFS::begin() ещё не вызывался,
+         * один раз пробует смонтировать без форматирования
+         * @return true если файловая система доступна
+         */
+        static bool ensureMounted() {
+            if (_mounted || _mountTried) return _mounted;
+            _mountTried = true;
+            _mounted = LittleFS.begin(false);
+            if (!_mounted) {
+                ST_LOG(STORAGE_LOG_WARNING, "FS: Filesystem not mounted (call StorageFS::begin())");
+            }
+            return _mounted;
+        }
+
+        /**
+         * Запомнить результат монтирования (вызывает StorageFS::begin())
+         */
+        static void setMounted(bool mounted) {
+            _mounted = mounted;
+            _mountTried = true;
+        }
+    };
+
+    inline StorageManagedFile::StorageManagedFile() { StorageManager::attach(this); }
+    inline StorageManagedFile::~StorageManagedFile() { StorageManager::detach(this); }
+
+    inline void StorageManagedFile::noteWrite(uint32_t us, size_t bytes) {
+        // Сглаживание 1/4: одна долгая запись (стирание блока) не ломает оценку
+        _writeUs = _writeUs ? _writeUs - _writeUs / 4 + us / 4 : us;
+        _writeBytes = (uint32_t)bytes;
+        StorageManager::noteWriteRate(us, bytes);
+    }
+
+    inline uint32_t StorageManagedFile::estimateWriteUs() const {
+        size_t bytes = pendingBytes();
+        if (_writeUs && _writeBytes) return (uint32_t)((uint64_t)_writeUs * bytes / _writeBytes);
+        return (uint32_t)((uint64_t)StorageManager::writeUsPerKb() * bytes / 1024);
+    }
+
+
+#endif
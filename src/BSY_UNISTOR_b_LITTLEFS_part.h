@@ -1,31 +1,201 @@
 #ifndef BSY_UNISTOR_B_LITTLEFS_PART_H
 #define BSY_UNISTOR_B_LITTLEFS_PART_H
+
+    #pragma pack(push, 1)
+    /**
+     * @struct StorageFileHeader
+     * @brief Заголовок файла StorageBigAkaFileSys.
+     * Сумма покрывает данные (несжатые), затем поля version..size.
+     * Файлы без заголовка (прежний формат [сумма][данные]) читаются как версия 0
+     */
+    struct StorageFileHeader {
+        uint32_t magic;
+        uint8_t version;     // версия схемы данных (setVersion)
+        uint8_t codec;       // формат тела: 0 - как есть, StorageRleCodec::id - RLE
+        uint8_t reserved[2];
+        uint32_t size;       // размер данных (после распаковки); тело - весь остаток файла
+        uint32_t crc;
+    };
+
+    /**
+     * @struct StorageDeltaCommit
+     * @brief Запись фиксации блочного режима (файл "<path>.commit"), за ней - номера
+     * блоков uint16_t. Целая запись означает: временные файлы этих блоков - новая версия,
+     * load() переименует оставшиеся. Сумма покрывает поля count..reserved и номера
+     */
+    struct StorageDeltaCommit {
+        uint32_t magic;
+        uint16_t count;      // сколько блоков
+        uint16_t reserved;
+        uint32_t crc;
+    };
+    #pragma pack(pop)
+
+    static constexpr uint32_t STORAGE_FILE_MAGIC = 0x31465342;  // "BSF1"
+    static constexpr size_t STORAGE_FILE_HASHED = sizeof(StorageFileHeader) - 8;  // поля version..size
+    static constexpr uint32_t STORAGE_DELTA_COMMIT_MAGIC = 0x31435342;  // "BSC1"
+    static constexpr size_t STORAGE_DELTA_COMMIT_HASHED = sizeof(StorageDeltaCommit) - 8;  // поля count..reserved
+
+    /**
+     * @class StorageOutStream
+     * @brief Поток записи для пользовательского сериализатора StorageBigAkaFileSys::setSerializer().
+     * Всё записанное сразу уходит в файл и в контрольную сумму
+     */
+    class StorageOutStream {
+    private:
+        File& _f;
+        void* _sum;
+        void (*_update)(void* sum, const void* data, size_t len);
+        size_t _size = 0;
+        bool _ok = true;
+    public:
+        StorageOutStream(File& f, void* sum, void (*update)(void*, const void*, size_t))
+            : _f(f), _sum(sum), _update(update) {}
+
+        /**
+         * Записать блок байт
+         * @return true если всё записано (после первой ошибки всегда false)
+         */
+        bool write(const void* data, size_t len) {
+            if (!_ok) return false;
+            _update(_sum, data, len);
+            _ok = _f.write((const uint8_t*)data, len) == len;
+            _size += len;
+            return _ok;
+        }
+
+        /**
+         * Записать значение простого типа
+         */
+        template <typename V>
+        bool put(const V& v) { return write(&v, sizeof(V)); }
+
+        bool ok() const { return _ok; }
+        size_t size() const { return _size; }
+    };
+
+    /**
+     * @class StorageInStream
+     * @brief Поток чтения для пользовательского сериализатора StorageBigAkaFileSys::setSerializer()
+     */
+    class StorageInStream {
+    private:
+        File& _f;
+        void* _sum;
+        void (*_update)(void* sum, const void* data, size_t len);
+        bool _ok = true;
+    public:
+        StorageInStream(File& f, void* sum, void (*update)(void*, const void*, size_t))
+            : _f(f), _sum(sum), _update(update) {}
+
+        /**
+         * Прочитать блок байт
+         * @return true если прочитано всё (после первой ошибки всегда false)
+         */
+        bool read(void* data, size_t len) {
+            if (!_ok) return false;
+            _ok = _f.read((uint8_t*)data, len) == len;
+            if (_ok) _update(_sum, data, len);
+            return _ok;
+        }
+
+        /**
+         * Прочитать значение простого типа
+         */
+        template <typename V>
+        bool get(V& v) { return read(&v, sizeof(V)); }
+
+        /**
+         * Сколько байт осталось в файле
+         */
+        size_t remaining() { return _f.available(); }
+
+        bool ok() const { return _ok; }
+    };
     /**
      * @class StorageBigAkaFileSys
      * @brief Класс для работы с файлами в LittleFS
      * @tparam T Тип хранимых данных
+     * @tparam Checksum Политика контрольной суммы (StorageCrc32, StorageXxHash32, ...)
+     * @tparam Lock Политика блокировки (StorageNoLock, StorageMutexLock)
+     * @tparam Codec Политика сжатия при записи (StorageRawCodec, StorageRleCodec).
+     * Сжатый вариант пишется, только если он меньше; читаются файлы любого формата
      */
-    template <typename T>
-    class StorageBigAkaFileSys {
+    template <typename T, typename Checksum = StorageCrc32, typename Lock = StorageDefaultLock,
+              typename Codec = StorageRawCodec>
+    class StorageBigAkaFileSys : public StorageManagedFile {
     private:
         const char* _path;
+#ifdef STORAGE_METRICS
+        StorageMetricsSource _metrics{_path, StorageMetricsSource::FS};
+#endif
         T& _data;
         uint32_t _intervalMs;
         uint32_t _lastChangeTime = 0;
         bool _isDirty = false;
-        bool _fsMounted = false;
         bool _debounceEnabled = true;
-        
-        // inline static работает с C++17
-        inline static bool _otaRunning = false;
+        bool _atomicSave = STORAGE_FS_ATOMIC_SAVE;
+        String _tmpPath;           // временный файл атомарной записи (_path + ".tmp")
+        bool _background = false;  // запись выполняет StorageWriter
+        volatile bool _queued = false;
+        volatile uint32_t _changeSeq = 0;  // счетчик update(), чтобы не потерять изменения во время записи
+        void (*_onSaved)(const char* path, bool ok) = nullptr;
+        Lock _lock;
+        std::unique_ptr<uint8_t[]> _snapshot;  // второй буфер для записи без блокировки
+
+        // Блочный режим (setDeltaSave): по файлу "<path>.<N>" на блок BLOCK_SIZE байт,
+        // save() переписывает только файлы блоков, помеченных update(offset, len)
+        static constexpr size_t BLOCK_SIZE = STORAGE_FS_DELTA_BLOCK;
+        static constexpr size_t BLOCK_COUNT = (sizeof(T) + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        static_assert(BLOCK_COUNT <= 0xFFFF, "STORAGE_FS_DELTA_BLOCK too small for this object");
+        bool _deltaSave = false;
+        bool _blocksValid = false;   // файлы всех блоков на флеше совпадают с _data, кроме помеченных
+        uint8_t _dirtyBlocks[(BLOCK_COUNT + 7) / 8] = {};
+        size_t _fileSize = StorageManager::UNKNOWN_SIZE;  // размер _path после последней записи/чтения
+
+        size_t _chunkSize = STORAGE_FS_CHUNK_SIZE;
+        uint8_t* _loadBuffer = nullptr;   // промежуточный буфер загрузки (PSRAM или свой), sizeof(T)
+        uint8_t* _stage = nullptr;        // буфер текущей загрузки (_loadBuffer или временный), nullptr - прямо в _data
+        bool _partial = false;            // текущая загрузка начала писать прямо в _data
+        bool (*_writeFn)(const T& obj, StorageOutStream& out) = nullptr;
+        bool (*_readFn)(T& obj, StorageInStream& in) = nullptr;
+        uint8_t _version = 0;
+        const StorageMigrations* _migrations = nullptr;
+        bool _sizeTolerant = false;   // загружать общий префикс, если размер T изменился
+
+        // Ленивая загрузка (loadLazy): файл читается при первом обращении
+        enum : uint8_t { LAZY_DONE, LAZY_PENDING, LAZY_LOADING };
+        volatile uint8_t _lazyState = LAZY_DONE;
+        volatile bool _lazyOk = true;
+        void (*_lazyReset)(T&) = nullptr;
+        portMUX_TYPE _lazyMux = portMUX_INITIALIZER_UNLOCKED;
+
+        StorageRtcShadow<T, Checksum>* _rtc = nullptr;   // RTC-копия (setRtcShadow)
+        uint16_t _rtcEvery = STORAGE_RTC_WRITE_EVERY;
+        bool _rtcForce = false;      // writeThrough(): писать файл, не дожидаясь writeEvery
 
         /**
-         * Проверка наличия свободного места
+         * Файловая система смонтирована (монтирование общее, см. StorageManager::ensureMounted)
+         */
+        bool mounted() const {
+            if (StorageManager::ensureMounted()) return true;
+            ST_LOG(STORAGE_LOG_ERROR, "FS: Filesystem not mounted for '%s'", _path);
+            return false;
+        }
+
+        /**
+         * Проверка наличия свободного места по кэшу статистики StorageManager.
+         * Если по кэшу места не хватает - пересчитываем, прежде чем отказать
+         * @param dataBytes Сколько байт данных собираемся записать
          * @return true если достаточно места для записи
          */
-        bool hasSpace() {
-            size_t free = LittleFS.totalBytes() - LittleFS.usedBytes();
-            size_t needed = sizeof(T) + 4 + 512;
+        bool hasSpace(size_t dataBytes) {
+            size_t free = StorageManager::freeSpace();
+            size_t needed = dataBytes + sizeof(StorageFileHeader) + 512;
+            if (free < needed) {
+                StorageManager::refreshStats();
+                free = StorageManager::freeSpace();
+            }
             if (free < needed) {
                 ST_LOG(STORAGE_LOG_ERROR, "FS: Low space for '%s'! Free: %u, Need: %u", 
                     _path, free, needed);
@@ -34,6 +204,786 @@
             return true;
         }
 
+        /**
+         * Потоковое чтение кусками прямо в буфер с подсчетом суммы по ходу
+         * @param f Открытый файл (позиция - начало данных)
+         * @param sum Политика контрольной суммы (begin() уже вызван)
+         * @param p Куда читать
+         * @param left Сколько байт прочитать
+         * @return true если прочитано всё
+         */
+        bool readChunked(File& f, Checksum& sum, uint8_t* p, size_t left) {
+            while (left) {
+                size_t len = left < _chunkSize ? left : _chunkSize;
+                if (f.read(p, len) != len) return false;
+                sum.update(p, len);
+                p += len;
+                left -= len;
+            }
+            return true;
+        }
+
+        /**
+         * Чтение тела файла в буфер: как есть или с распаковкой по hdr.codec.
+         * Сумма считается по распакованным данным
+         * @param f Открытый файл (позиция - начало тела)
+         * @param sum Политика контрольной суммы (begin() уже вызван)
+         * @param hdr Заголовок файла (hdr.size байт данных)
+         * @param dst Куда читать (не меньше hdr.size байт)
+         * @return true если данные прочитаны полностью
+         */
+        bool readData(File& f, Checksum& sum, const StorageFileHeader& hdr, uint8_t* dst) {
+            if (dst == (uint8_t*)&_data) _partial = true;
+            if (!hdr.codec) return readChunked(f, sum, dst, hdr.size);
+            if (hdr.codec != StorageRleCodec::id) {
+                ST_LOG(STORAGE_LOG_ERROR, "FS: Unknown codec %u in '%s'", hdr.codec, f.name());
+                return false;
+            }
+            auto read = [&](uint8_t* p, size_t n) { return (size_t)f.read(p, n); };
+            if (!StorageRleCodec::decode(read, f.size() - sizeof(StorageFileHeader), dst, hdr.size)) return false;
+            sum.update(dst, hdr.size);
+            return true;
+        }
+
+        /**
+         * Потоковая запись кусками с подсчетом суммы по ходу
+         * @param f Открытый файл (позиция - начало данных)
+         * @param sum Политика контрольной суммы (begin() уже вызван)
+         * @param p Источник: _data или его снимок
+         * @param left Сколько байт записать
+         * @return true если записано всё
+         */
+        bool writeChunked(File& f, Checksum& sum, const uint8_t* p, size_t left) {
+            while (left) {
+                size_t len = left < _chunkSize ? left : _chunkSize;
+                sum.update(p, len);
+                if (f.write(p, len) != len) return false;
+                p += len;
+                left -= len;
+            }
+            return true;
+        }
+
+        static void sumUpdate(void* sum, const void* data, size_t len) {
+            static_cast<Checksum*>(sum)->update(data, len);
+        }
+
+        /**
+         * Чтение файла [заголовок][тело] с проверкой целостности
+         * @param path Путь к файлу
+         * @param hdr Сюда кладется заголовок (для файла прежнего формата - version 0)
+         * @param accept Проверяет заголовок до чтения тела: bool(const StorageFileHeader&)
+         * @param body Читает тело: bool(File&, Checksum&, const StorageFileHeader&)
+         * @return true если файл прочитан полностью и сумма совпала
+         */
+        template <typename Accept, typename Body>
+        bool readWith(const char* path, StorageFileHeader& hdr, Accept accept, Body body) {
+            File f = LittleFS.open(path, "r");
+            if (!f) {
+                ST_LOG(STORAGE_LOG_WARNING, "FS: File '%s' not found", path);
+                return false;
+            }
+
+            size_t fileSize = f.size();
+            if (path == _path) _fileSize = fileSize;
+            bool ok = f.read((uint8_t*)&hdr.magic, 4) == 4;
+            if (ok && hdr.magic == STORAGE_FILE_MAGIC) {
+                ok = f.read((uint8_t*)&hdr + 4, sizeof(hdr) - 4) == sizeof(hdr) - 4
+                    && (hdr.codec || hdr.size == fileSize - sizeof(hdr));
+            } else if (ok) {
+                // Прежний формат: [сумма][данные], без версии
+                hdr.crc = hdr.magic;
+                hdr.magic = 0;
+                hdr.version = 0;
+                hdr.codec = 0;
+                memset(hdr.reserved, 0, sizeof(hdr.reserved));
+                hdr.size = fileSize - 4;
+            }
+
+            if (ok && !accept(hdr)) {
+                f.close();
+                return false;
+            }
+
+            Checksum sum;
+            sum.begin();
+            ok = ok && body(f, sum, hdr);
+            f.close();
+
+            if (!ok) {
+                ST_LOG(STORAGE_LOG_ERROR, "FS: Read error from '%s'", path);
+                return false;
+            }
+
+            if (hdr.magic) sum.update(&hdr.version, STORAGE_FILE_HASHED);
+            uint32_t crc = sum.finish();
+            if (crc != hdr.crc) {
+                ST_LOG(STORAGE_LOG_ERROR, "FS: CRC error in '%s' (stored: 0x%08X, calc: 0x%08X)", 
+                    path, hdr.crc, crc);
+                ST_METRIC(_metrics.m.crcErrors++);
+                return false;
+            }
+            return true;
+        }
+
+        /**
+         * Чтение файла с данными фиксированного размера текущей версии
+         * @param path Путь к файлу (основной, временный или файл блока)
+         * @param dst Куда читать данные
+         * @param len Ожидаемый размер данных
+         * @param crc Сюда кладется сумма файла
+         * @return true если файл прочитан полностью и сумма совпала
+         */
+        bool readBlob(const char* path, uint8_t* dst, size_t len, uint32_t& crc) {
+            StorageFileHeader hdr;
+            bool ok = readWith(path, hdr, [&](const StorageFileHeader& h) {
+                if (h.version == _version && h.size == len) return true;
+                ST_LOG(STORAGE_LOG_WARNING, "FS: '%s' is v%u, %u bytes (expected v%u, %u bytes)", 
+                    path, h.version, h.size, _version, (uint32_t)len);
+                return false;
+            }, [&](File& f, Checksum& sum, const StorageFileHeader& h) {
+                return readData(f, sum, h, dst);
+            });
+            crc = hdr.crc;
+            return ok;
+        }
+
+        /**
+         * Чтение объекта другой версии (через цепочку миграций) или другого размера
+         * (setSizeTolerant: общий префикс, хвост _data не меняется). Объект пишется байтами.
+         * Данные читаются в отдельный буфер - при ошибке _data не меняется
+         * @return true если объект переведен в текущую версию и размер
+         */
+        bool readConverted(const char* path, uint32_t& crc) {
+            StorageFileHeader hdr;
+            std::unique_ptr<uint8_t[]> buf;
+            size_t capacity = 0;
+            bool ok = readWith(path, hdr, [](const StorageFileHeader&) {
+                return true;
+            }, [&](File& f, Checksum& sum, const StorageFileHeader& h) {
+                capacity = _migrations ? _migrations->capacityFor(h.size, sizeof(T))
+                                       : (h.size > sizeof(T) ? h.size : sizeof(T));
+                buf.reset(new (std::nothrow) uint8_t[capacity]);
+                if (!buf) {
+                    ST_LOG(STORAGE_LOG_ERROR, "FS: No RAM to migrate '%s' (%u bytes)", path, (uint32_t)capacity);
+                    return false;
+                }
+                return readData(f, sum, h, buf.get());
+            });
+            crc = hdr.crc;
+            if (!ok) return false;
+
+            size_t size = hdr.size;
+            if (hdr.version != _version && (!_migrations 
+                    || !_migrations->apply(buf.get(), size, capacity, hdr.version, _version))) {
+                ST_LOG(STORAGE_LOG_WARNING, "FS: No migration for '%s' v%u -> v%u", path, hdr.version, _version);
+                return false;
+            }
+            if (size != sizeof(T) && !_sizeTolerant) {
+                ST_LOG(STORAGE_LOG_ERROR, "FS: '%s' has %u bytes, expected %u", 
+                    path, (uint32_t)size, (uint32_t)sizeof(T));
+                return false;
+            }
+            // Общий префикс; хвост более длинной структуры - значения по умолчанию из load()
+            memcpy((void*)&_data, buf.get(), size < sizeof(T) ? size : sizeof(T));
+            // Обратная запись - обычным порядком, по истечении дебаунса
+            _isDirty = true;
+            _changeSeq++;
+            _lastChangeTime = millis();
+            memset(_dirtyBlocks, 0xFF, sizeof(_dirtyBlocks));
+            StorageManager::schedule(deadline());
+            ST_LOG(STORAGE_LOG_INFO, "FS: '%s' converted v%u (%u bytes) -> v%u (%u bytes)", 
+                path, hdr.version, hdr.size, _version, (uint32_t)sizeof(T));
+            return true;
+        }
+
+        /**
+         * Чтение всего объекта: через сериализатор или байтами.
+         * С буфером загрузки (_stage) _data меняется только после проверки суммы
+         * @param path Путь к файлу
+         * @param crc Сюда кладется сумма файла
+         * @return true если объект прочитан и проверен
+         */
+        bool readObject(const char* path, uint32_t& crc) {
+            if (_readFn) {
+                StorageFileHeader hdr;
+                bool ok = readWith(path, hdr, [&](const StorageFileHeader& h) {
+                    if (h.version == _version && !h.codec) return true;
+                    ST_LOG(STORAGE_LOG_WARNING, "FS: '%s' is v%u (codec %u), expected v%u", 
+                        path, h.version, h.codec, _version);
+                    return false;
+                }, [&](File& f, Checksum& sum, const StorageFileHeader&) {
+                    StorageInStream in(f, &sum, sumUpdate);
+                    return _readFn(_data, in) && in.ok() && in.remaining() == 0;
+                });
+                crc = hdr.crc;
+                return ok;
+            }
+            uint8_t* dst = _stage ? _stage : (uint8_t*)&_data;
+            if (readBlob(path, dst, sizeof(T), crc)) {
+                if (_stage) memcpy((void*)&_data, _stage, sizeof(T));
+                return true;
+            }
+            return (_migrations || _sizeTolerant) && LittleFS.exists(path) && readConverted(path, crc);
+        }
+
+        /**
+         * Заменить основной файл полностью записанным временным.
+         * rename в LittleFS атомарно замещает существующий файл
+         * @return true если временный файл стал основным
+         */
+        static bool commitTemp(const char* tmpPath, const char* path) {
+            if (LittleFS.rename(tmpPath, path)) return true;
+            // Запасной путь для реализаций без замещения: копия в .tmp уже полная,
+            // load() подхватит её, если питание пропадёт между remove и rename
+            LittleFS.remove(path);
+            return LittleFS.rename(tmpPath, path);
+        }
+
+        /**
+         * Размер _path до записи для учета в кэше статистики: запомненный после прошлой
+         * записи или чтения, запрос к LittleFS - только если размер неизвестен
+         * @return Размер (0 - файла нет или кэш статистики пуст)
+         */
+        size_t sizeBeforeWrite() {
+            if (!StorageManager::statsValid()) return 0;
+            if (_fileSize == StorageManager::UNKNOWN_SIZE) _fileSize = StorageManager::fileSize(_path);
+            return _fileSize;
+        }
+
+        /**
+         * Запись файла [заголовок][тело], при атомарном режиме через временный файл
+         * @param path Основной путь
+         * @param tmpPath Временный путь (используется при _atomicSave)
+         * @param crc Сюда кладется записанная сумма
+         * @param body Пишет тело и заполняет hdr.size (и hdr.codec): bool(File&, Checksum&, StorageFileHeader& hdr)
+         * @return true если файл записан полностью
+         */
+        template <typename Body>
+        bool writeWith(const char* path, const char* tmpPath, uint32_t& crc, Body body) {
+            // В атомарном режиме пишем во временный файл, старая версия живёт до rename
+            const char* target = _atomicSave ? tmpPath : path;
+            size_t oldSize = sizeBeforeWrite();
+            File f = LittleFS.open(target, "w");
+            if (!f) {
+                ST_LOG(STORAGE_LOG_ERROR, "FS: Can't write '%s'", target);
+                return false;
+            }
+            
+            // Место под заголовок резервируем, сумму считаем по ходу записи и дописываем в начало
+            StorageFileHeader hdr = { STORAGE_FILE_MAGIC, _version, 0, {0, 0}, 0, 0 };
+            Checksum sum;
+            sum.begin();
+            bool ok = (f.write((uint8_t*)&hdr, sizeof(hdr)) == sizeof(hdr)) && body(f, sum, hdr);
+            if (ok) {
+                sum.update(&hdr.version, STORAGE_FILE_HASHED);
+                hdr.crc = sum.finish();
+                ok = f.seek(0) && (f.write((uint8_t*)&hdr, sizeof(hdr)) == sizeof(hdr));
+            }
+            crc = hdr.crc;
+            size_t newSize = f.size();
+            f.close();
+            
+            if (!ok) {
+                ST_LOG(STORAGE_LOG_ERROR, "FS: Write error for '%s'", target);
+                if (_atomicSave) LittleFS.remove(target);
+                StorageManager::invalidateStats();
+                _fileSize = StorageManager::UNKNOWN_SIZE;
+                return false;
+            }
+
+            if (_atomicSave && !commitTemp(tmpPath, path)) {
+                ST_LOG(STORAGE_LOG_ERROR, "FS: Can't rename '%s' -> '%s'", tmpPath, path);
+                StorageManager::invalidateStats();
+                _fileSize = StorageManager::UNKNOWN_SIZE;
+                return false;
+            }
+            StorageManager::noteFileSize(oldSize, newSize);
+            _fileSize = newSize;
+            return true;
+        }
+
+        /**
+         * Размер данных после сжатия политикой Codec
+         * @return Размер сжатых данных или 0, если сжатие выключено или не дает выигрыша
+         */
+        static size_t packedSize(const uint8_t* src, size_t len) {
+            if constexpr (Codec::id == StorageRawCodec::id) {
+                return 0;
+            } else {
+                size_t packed = Codec::encodedSize(src, len);
+                return packed < len ? packed : 0;
+            }
+        }
+
+        /**
+         * Запись файла [заголовок][данные] фиксированного размера
+         * @param packed Размер после сжатия из packedSize() (0 - писать как есть)
+         */
+        bool writeBlob(const char* path, const char* tmpPath, const uint8_t* src, size_t len, 
+                       size_t packed, uint32_t& crc) {
+            return writeWith(path, tmpPath, crc, [&](File& f, Checksum& sum, StorageFileHeader& hdr) {
+                hdr.size = len;
+                if constexpr (Codec::id != StorageRawCodec::id) {
+                    if (packed) {
+                        hdr.codec = Codec::id;
+                        sum.update(src, len);
+                        auto sink = [&](const uint8_t* p, size_t n) { return f.write(p, n) == n; };
+                        return Codec::encode(src, len, sink) == packed;
+                    }
+                }
+                return writeChunked(f, sum, src, len);
+            });
+        }
+
+        /**
+         * Блочный режим действует только для объектов, которые пишутся байтами
+         */
+        bool blockMode() const {
+            return _deltaSave && !_writeFn;
+        }
+
+        /**
+         * Снимок _data для записи без удержания блокировки (вызывать под _lock).
+         * Без блокирующей политики снимок не нужен
+         * @return Указатель на снимок или nullptr (писать прямо из _data)
+         */
+        const uint8_t* takeSnapshot() {
+            if constexpr (!Lock::enabled) {
+                return nullptr;
+            } else {
+                if (_writeFn) return nullptr;  // объект с сериализатором нельзя копировать memcpy
+                if (!_snapshot) {
+                    _snapshot.reset(new (std::nothrow) uint8_t[sizeof(T)]);
+                    if (!_snapshot) {
+                        ST_LOG(STORAGE_LOG_WARNING, "FS: No RAM for snapshot of '%s', writing under lock", _path);
+                        return nullptr;
+                    }
+                }
+                memcpy(_snapshot.get(), &_data, sizeof(T));
+                return _snapshot.get();
+            }
+        }
+
+        static bool blockBit(const uint8_t* bits, size_t i) { return bits[i >> 3] & (1 << (i & 7)); }
+
+        static constexpr size_t blockLen(size_t i) {
+            return sizeof(T) - i * BLOCK_SIZE < BLOCK_SIZE ? sizeof(T) - i * BLOCK_SIZE : BLOCK_SIZE;
+        }
+
+        /**
+         * Пометить измененными блоки, задевающие диапазон (вызывать под _lock)
+         */
+        void markBlocks(size_t offset, size_t len) {
+            if (!len || offset >= sizeof(T)) return;
+            if (len > sizeof(T) - offset) len = sizeof(T) - offset;
+            for (size_t i = offset / BLOCK_SIZE; i <= (offset + len - 1) / BLOCK_SIZE; i++) {
+                _dirtyBlocks[i >> 3] |= (1 << (i & 7));
+            }
+        }
+
+        String blockPath(size_t i) const { return String(_path) + "." + String((unsigned)i); }
+        String blockTmpPath(size_t i) const { return blockPath(i) + ".tmp"; }
+        String commitPath() const { return String(_path) + ".commit"; }
+
+        static constexpr size_t blockFileSize(size_t i) { return sizeof(StorageFileHeader) + blockLen(i); }
+        static constexpr size_t commitFileSize(size_t count) {
+            return sizeof(StorageDeltaCommit) + count * sizeof(uint16_t);
+        }
+
+        /**
+         * Сколько байт уйдет на флеш при записи блоков из bits: файлы блоков
+         * и, если блоков несколько и запись атомарная, запись фиксации
+         */
+        size_t blockBytes(const uint8_t* bits) const {
+            size_t bytes = 0, count = 0;
+            for (size_t i = 0; i < BLOCK_COUNT; i++) {
+                if (!blockBit(bits, i)) continue;
+                bytes += blockFileSize(i);
+                count++;
+            }
+            return _atomicSave && count > 1 ? bytes + commitFileSize(count) : bytes;
+        }
+
+        /**
+         * Файл блока [заголовок][данные блока i]. Сумма считается заранее, и файл пишется
+         * одним проходом: возврат к заголовку заставил бы LittleFS переписать файл еще раз
+         * @param target Путь файла блока или его временного файла
+         * @param crc Сюда кладется сумма блока
+         * @return true если файл записан полностью
+         */
+        bool writeBlockFile(const char* target, const uint8_t* src, size_t i, uint32_t& crc) {
+            File f = LittleFS.open(target, "w");
+            if (!f) {
+                ST_LOG(STORAGE_LOG_ERROR, "FS: Can't write '%s'", target);
+                return false;
+            }
+            const uint8_t* p = src + i * BLOCK_SIZE;
+            StorageFileHeader hdr = { STORAGE_FILE_MAGIC, _version, 0, {0, 0}, (uint32_t)blockLen(i), 0 };
+            Checksum sum;
+            sum.begin();
+            sum.update(p, blockLen(i));
+            sum.update(&hdr.version, STORAGE_FILE_HASHED);
+            hdr.crc = crc = sum.finish();
+            bool ok = f.write((const uint8_t*)&hdr, sizeof(hdr)) == sizeof(hdr)
+                && f.write(p, blockLen(i)) == blockLen(i);
+            f.close();
+            if (!ok) ST_LOG(STORAGE_LOG_ERROR, "FS: Write error for '%s'", target);
+            return ok;
+        }
+
+        /**
+         * Запись фиксации [StorageDeltaCommit][номера блоков uint16_t]: с момента, когда она
+         * целиком на флеше, временные файлы блоков из bits считаются новой версией
+         * @return true если запись фиксации записана полностью
+         */
+        bool writeCommit(const uint8_t* bits, size_t count) {
+            StorageDeltaCommit rec = { STORAGE_DELTA_COMMIT_MAGIC, (uint16_t)count, 0, 0 };
+            Checksum sum;
+            sum.begin();
+            sum.update(&rec.count, STORAGE_DELTA_COMMIT_HASHED);
+            for (size_t i = 0; i < BLOCK_COUNT; i++) {
+                uint16_t index = i;
+                if (blockBit(bits, i)) sum.update(&index, sizeof(index));
+            }
+            rec.crc = sum.finish();
+
+            String path = commitPath();
+            File f = LittleFS.open(path.c_str(), "w");
+            bool ok = f && f.write((const uint8_t*)&rec, sizeof(rec)) == sizeof(rec);
+            for (size_t i = 0; ok && i < BLOCK_COUNT; i++) {
+                uint16_t index = i;
+                if (blockBit(bits, i)) ok = f.write((const uint8_t*)&index, sizeof(index)) == sizeof(index);
+            }
+            if (f) f.close();
+            if (!ok) {
+                ST_LOG(STORAGE_LOG_ERROR, "FS: Write error for '%s'", path.c_str());
+                LittleFS.remove(path.c_str());
+            }
+            return ok;
+        }
+
+        /**
+         * Довести до конца запись, прерванную после фиксации: временные файлы блоков
+         * из записи фиксации - на место, сама запись удаляется. Недописанная запись
+         * фиксации (сбой до точки фиксации) просто удаляется: блоки остались прежними
+         * @return true если незавершенной записи не осталось
+         */
+        bool finishCommit() {
+            String path = commitPath();
+            if (!LittleFS.exists(path.c_str())) return true;
+            File f = LittleFS.open(path.c_str(), "r");
+            StorageDeltaCommit rec;
+            bool ok = f && f.read((uint8_t*)&rec, sizeof(rec)) == sizeof(rec)
+                && rec.magic == STORAGE_DELTA_COMMIT_MAGIC && rec.count && rec.count <= BLOCK_COUNT
+                && (size_t)f.size() == commitFileSize(rec.count);
+            // Первый проход - только сумма, второй - rename
+            Checksum sum;
+            sum.begin();
+            if (ok) sum.update(&rec.count, STORAGE_DELTA_COMMIT_HASHED);
+            for (size_t k = 0; ok && k < rec.count; k++) {
+                uint16_t index;
+                ok = f.read((uint8_t*)&index, sizeof(index)) == sizeof(index) && index < BLOCK_COUNT;
+                if (ok) sum.update(&index, sizeof(index));
+            }
+            ok = ok && sum.finish() == rec.crc && f.seek(sizeof(rec));
+            bool done = true;
+            for (size_t k = 0; ok && k < rec.count; k++) {
+                uint16_t index;
+                ok = f.read((uint8_t*)&index, sizeof(index)) == sizeof(index);
+                String tmp = blockTmpPath(index);
+                // Нет временного файла - этот блок уже переименован до сбоя
+                if (ok && LittleFS.exists(tmp.c_str())) done = commitTemp(tmp.c_str(), blockPath(index).c_str()) && done;
+            }
+            if (f) f.close();
+            StorageManager::invalidateStats();
+            if (!done) {
+                ST_LOG(STORAGE_LOG_ERROR, "FS: Can't complete interrupted save of '%s'", _path);
+                return false;
+            }
+            LittleFS.remove(path.c_str());
+            if (ok) ST_LOG(STORAGE_LOG_WARNING, "FS: '%s' interrupted save of %u blocks completed", _path, rec.count);
+            return true;
+        }
+
+        /**
+         * Блочный режим: записать блоки из bits, каждый в свой файл "<path>.<N>" - LittleFS
+         * не трогает файлы неизмененных блоков. Один блок заменяется через временный файл
+         * и rename. Несколько - сначала все во временные файлы, затем запись фиксации
+         * "<path>.commit" (точка фиксации), затем rename и удаление записи: после сбоя
+         * load() видит прежнюю версию или доводит новую до конца (finishCommit).
+         * Без атомарного режима файлы блоков переписываются на месте.
+         * После первой полной записи удаляется файл обычного формата (до setDeltaSave)
+         * @return true если все блоки на месте
+         */
+        bool writeBlocks(const uint8_t* src, const uint8_t* bits, uint32_t& crc, size_t& written) {
+            size_t count = 0;
+            for (size_t i = 0; i < BLOCK_COUNT; i++) count += blockBit(bits, i);
+            if (!count) return true;
+            size_t bytes = blockBytes(bits);
+            if (!hasSpace(bytes)) return false;
+            if (_atomicSave && !finishCommit()) return false;
+
+            bool staged = _atomicSave && count > 1;
+            bool full = !_blocksValid;  // размеры файлов на флеше неизвестны
+            auto fail = [&](const char* what, const char* path) {
+                ST_LOG(STORAGE_LOG_ERROR, "FS: %s '%s'", what, path);
+                StorageManager::invalidateStats();
+                return false;
+            };
+            auto oldSize = [&](const String& path, size_t i) -> size_t {
+                if (!full) return blockFileSize(i);
+                return StorageManager::statsValid() ? StorageManager::fileSize(path.c_str()) : 0;
+            };
+
+            for (size_t i = 0; i < BLOCK_COUNT; i++) {
+                if (!blockBit(bits, i)) continue;
+                String path = blockPath(i);
+                if (!_atomicSave) {
+                    size_t old = oldSize(path, i);
+                    if (!writeBlockFile(path.c_str(), src, i, crc)) return fail("Can't save block", path.c_str());
+                    StorageManager::noteFileSize(old, blockFileSize(i));
+                    continue;
+                }
+                String tmp = blockTmpPath(i);
+                if (!writeBlockFile(tmp.c_str(), src, i, crc)) {
+                    LittleFS.remove(tmp.c_str());
+                    return fail("Can't save block", tmp.c_str());
+                }
+                if (staged) {
+                    StorageManager::noteFileSize(0, blockFileSize(i));
+                    continue;
+                }
+                size_t old = oldSize(path, i);
+                if (!commitTemp(tmp.c_str(), path.c_str())) return fail("Can't rename", tmp.c_str());
+                StorageManager::noteFileSize(old, blockFileSize(i));
+            }
+
+            if (staged) {
+                if (!writeCommit(bits, count)) return fail("Can't commit", _path);
+                StorageManager::noteFileSize(0, commitFileSize(count));
+                for (size_t i = 0; i < BLOCK_COUNT; i++) {
+                    if (!blockBit(bits, i)) continue;
+                    String path = blockPath(i), tmp = blockTmpPath(i);
+                    size_t old = oldSize(path, i);
+                    // Запись уже зафиксирована - оставшиеся rename доделает finishCommit()
+                    if (!commitTemp(tmp.c_str(), path.c_str())) return fail("Can't rename", tmp.c_str());
+                    StorageManager::noteFileSize(old + blockFileSize(i), blockFileSize(i));
+                }
+                String rec = commitPath();
+                StorageManager::removeFile(rec.c_str(), commitFileSize(count));
+            }
+
+            if (full && LittleFS.exists(_path)) {
+                StorageManager::removeFile(_path, _fileSize);
+                _fileSize = 0;
+            }
+            written = bytes;
+            return true;
+        }
+
+        /**
+         * Запись (под IoGuard): один файл целиком или, в блочном режиме, только блоки из bits
+         * @param src Источник (sizeof(T) байт)
+         * @param bits Битовая карта блоков для записи (только блочный режим)
+         * @param crc Сумма записанного файла (в блочном режиме - последнего блока)
+         * @param written Сколько байт записано на флеш (после сжатия)
+         * @return true если всё записано
+         */
+        bool writeFile(const uint8_t* src, const uint8_t* bits, uint32_t& crc, size_t& written) {
+            StorageWriter::IoGuard io;
+            written = 0;
+
+            if (_writeFn) {
+                if (!hasSpace(sizeof(T))) return false;
+                size_t size = 0;
+                bool ok = writeWith(_path, _tmpPath.c_str(), crc, [&](File& f, Checksum& sum, StorageFileHeader& hdr) {
+                    StorageOutStream out(f, &sum, sumUpdate);
+                    bool res = _writeFn(_data, out) && out.ok();
+                    hdr.size = size = out.size();
+                    return res;
+                });
+                if (ok) written = size;
+                return ok;
+            }
+
+            if (!blockMode()) {
+                size_t packed = packedSize(src, sizeof(T));
+                if (!hasSpace(packed ? packed : sizeof(T))) return false;
+                if (!writeBlob(_path, _tmpPath.c_str(), src, sizeof(T), packed, crc)) return false;
+                written = packed ? packed : sizeof(T);
+                return true;
+            }
+
+            return writeBlocks(src, bits, crc, written);
+        }
+
+        /**
+         * Чтение файлов блоков в _data (блочный режим). Сначала доводится до конца
+         * запись, прерванная после фиксации
+         * @return true если все блоки на месте и их суммы совпали
+         */
+        bool loadBlocks() {
+            _blocksValid = false;
+            {
+                StorageWriter::IoGuard io;
+                if (!finishCommit()) return false;
+            }
+            uint8_t* dst = _stage ? _stage : (uint8_t*)&_data;
+            uint32_t crc;
+            for (size_t i = 0; i < BLOCK_COUNT; i++) {
+                if (!readBlob(blockPath(i).c_str(), dst + i * BLOCK_SIZE, blockLen(i), crc)) return false;
+            }
+            if (_stage) memcpy((void*)&_data, _stage, sizeof(T));
+            _blocksValid = true;
+            memset(_dirtyBlocks, 0, sizeof(_dirtyBlocks));
+            ST_LOG(STORAGE_LOG_INFO, "FS: '%s' loaded OK (size: %u, blocks: %u)", 
+                _path, sizeof(T), (uint32_t)BLOCK_COUNT);
+            return true;
+        }
+
+        /**
+         * Данные по ошибке загрузки: resetFunc, а без неё - нули, если чтение
+         * успело начать перезаписывать _data (иначе _data не тронут)
+         */
+        void resetAfterFailure(void (*resetFunc)(T&)) {
+            if (resetFunc) resetFunc(_data);
+            else if (_partial) memset((void*)&_data, 0, sizeof(T));
+        }
+
+        /**
+         * Чтение объекта с проверкой целостности (load() и ленивая загрузка).
+         * Байтовый объект читается через промежуточный буфер: setLoadBuffer() или
+         * временный из кучи (до STORAGE_FS_STAGED_LOAD_MAX байт), так что _data меняется
+         * только целиком проверенными данными
+         * @param resetFunc Функция для сброса данных при ошибке
+         * @return true если данные загружены успешно
+         */
+        bool loadFile(void (*resetFunc)(T&)) {
+            if (!mounted()) return false;
+            StorageLockGuard<Lock> guard(_lock);
+            ST_METRIC(StorageMetricTimer timer(_metrics.m.load));
+
+            std::unique_ptr<uint8_t[]> temp;
+            _stage = _loadBuffer;
+            if (!_stage && !_writeFn && sizeof(T) <= STORAGE_FS_STAGED_LOAD_MAX) {
+                temp.reset(new (std::nothrow) uint8_t[sizeof(T)]);
+                _stage = temp.get();
+                if (!_stage) ST_LOG(STORAGE_LOG_WARNING, "FS: No RAM to stage '%s', reading into data", _path);
+            }
+            _partial = false;
+            bool ok = loadStaged(resetFunc);
+            _stage = nullptr;
+            return ok;
+        }
+
+        /**
+         * Тело loadFile() (под _lock, буфер загрузки выбран)
+         */
+        bool loadStaged(void (*resetFunc)(T&)) {
+            ST_LOG(STORAGE_LOG_INFO, "FS: Read '%s'...", _path);
+            uint32_t crc;
+            // Файл короче структуры заполнит только начало - остальное берем из функции сброса
+            if (_sizeTolerant && resetFunc) resetFunc(_data);
+
+            if (blockMode()) {
+                if (loadBlocks()) {
+                    if (LittleFS.exists(_path)) StorageManager::removeFile(_path);  // остался от перехода
+                    return true;
+                }
+                // Возможно, файл обычного формата (до setDeltaSave): читаем его,
+                // а в блочный формат он перепишется при следующей записи
+                if (readObject(_path, crc)) {
+                    ST_LOG(STORAGE_LOG_INFO, "FS: '%s' loaded from single file, will be rewritten in blocks", _path);
+                    _isDirty = true;
+                    _changeSeq++;
+                    _lastChangeTime = millis();
+                    StorageManager::schedule(deadline());
+                    return true;
+                }
+                resetAfterFailure(resetFunc);
+                save();
+                return false;
+            }
+
+            if (readObject(_path, crc)) {
+                if (_atomicSave && LittleFS.exists(_tmpPath.c_str())) {
+                    LittleFS.remove(_tmpPath.c_str());  // недописанная копия от прерванной записи
+                }
+                ST_LOG(STORAGE_LOG_INFO, "FS: '%s' loaded OK (size: %u, CRC: 0x%08X)", 
+                    _path, sizeof(T), crc);
+                return true;
+            }
+
+            // Основной файл испорчен/отсутствует, но новая копия успела записаться целиком -
+            // доводим замену до конца вместо сброса в дефолт и полной перезаписи
+            if (_atomicSave && LittleFS.exists(_tmpPath.c_str()) 
+                    && readObject(_tmpPath.c_str(), crc)) {
+                _fileSize = StorageManager::UNKNOWN_SIZE;
+                if (!commitTemp(_tmpPath.c_str(), _path)) {
+                    ST_LOG(STORAGE_LOG_WARNING, "FS: Recovered '%s' from '%s', rename deferred to next save", 
+                        _path, _tmpPath.c_str());
+                } else {
+                    ST_LOG(STORAGE_LOG_WARNING, "FS: '%s' recovered from '%s' (CRC: 0x%08X)", 
+                        _path, _tmpPath.c_str(), crc);
+                }
+                return true;
+            }
+
+            resetAfterFailure(resetFunc);
+            save();
+            return false;
+        }
+
+        /**
+         * Запись в фоне через StorageWriter, если она включена, иначе сразу.
+         * Если очередь переполнена - пишем сами, чтобы не потерять данные
+         */
+        void requestSave() override {
+            if (!_background || !StorageWriter::isRunning()) {
+                save();
+                return;
+            }
+            if (_queued) return;
+            _queued = true;
+            if (!StorageWriter::enqueue(this, runSave)) {
+                _queued = false;
+                save();
+            }
+        }
+
+        /**
+         * Оценка объёма ближайшей записи: в блочном режиме - файлы помеченных блоков
+         * (до первой записи - всех) и запись фиксации
+         */
+        size_t pendingBytes() const override {
+            if (!blockMode()) return sizeof(T);
+            if (_blocksValid) return blockBytes(_dirtyBlocks);
+            uint8_t all[sizeof(_dirtyBlocks)];
+            memset(all, 0xFF, sizeof(all));
+            return blockBytes(all);
+        }
+
+        /**
+         * Предзагрузка для StorageManager::prefetchAll()
+         */
+        bool prefetch() override {
+            if (_lazyState != LAZY_PENDING) return false;
+            ensureLoaded();
+            return true;
+        }
+
+        /**
+         * Точка входа задачи-писателя
+         */
+        static bool runSave(void* self) {
+            StorageBigAkaFileSys* s = static_cast<StorageBigAkaFileSys*>(self);
+            s->_queued = false;
+            bool ok = s->save();
+            if (s->_onSaved) s->_onSaved(s->_path, ok);
+            return ok;
+        }
+
     public:
         /**
          * Конструктор файлового объекта
@@ -46,19 +996,16 @@
                             bool debounceEnabled = true) 
             : _path(path), _data(data), _intervalMs(intervalSec * 1000), 
             _debounceEnabled(debounceEnabled) {
-            _fsMounted = LittleFS.begin(false);
-            if (!_fsMounted) {
-                ST_LOG(STORAGE_LOG_WARNING, "FS: Filesystem not mounted for '%s'", _path);
-            }
+            _tmpPath = String(_path) + ".tmp";
         }
 
         /**
-         * Установить статус работы OTA
+         * Установить статус работы OTA (общий для всех файловых хранилищ,
+         * см. StorageManager::setOtaRunning)
          * @param state true если выполняется OTA обновление
          */
         static void setOtaRunning(bool state) { 
-            _otaRunning = state;
-            ST_LOG(STORAGE_LOG_INFO, "FS: OTA running state set to %s", state ? "true" : "false");
+            StorageManager::setOtaRunning(state);
         }
 
         /**
@@ -66,7 +1013,7 @@
          * @return true если выполняется OTA обновление
          */
         static bool isOtaRunning() { 
-            return _otaRunning;
+            return StorageManager::isOtaRunning();
         }
 
         /**
@@ -75,115 +1022,224 @@
          * @return true если данные загружены успешно
          */
         bool load(void (*resetFunc)(T&) = nullptr) {
-            if (!_fsMounted) {
-                ST_LOG(STORAGE_LOG_ERROR, "FS: Filesystem not mounted for '%s'", _path);
-                return false;
-            }
-            
-            ST_LOG(STORAGE_LOG_INFO, "FS: Read '%s'...", _path);
-            File f = LittleFS.open(_path, "r");
-            if (!f) {
-                ST_LOG(STORAGE_LOG_WARNING, "FS: File '%s' not found", _path);
-                if (resetFunc) resetFunc(_data);
-                save();
-                return false;
+            if (_rtc && !_writeFn && _rtc->restore(_data)) {
+                ST_LOG(STORAGE_LOG_INFO, "FS: '%s' restored from RTC (%u saves not in flash)", _path, _rtc->cycles);
+                _lazyOk = true;
+                _lazyState = LAZY_DONE;
+                return true;
             }
+            bool ok = loadFile(resetFunc);
+            if (ok && _rtc && !_writeFn) _rtc->adopt(_data);
+            _lazyOk = ok;
+            _lazyState = LAZY_DONE;
+            return ok;
+        }
 
-            uint32_t storedCrc;
-            bool ok = (f.read((uint8_t*)&storedCrc, 4) == 4) && 
-                    (f.read((uint8_t*)&_data, sizeof(T)) == sizeof(T));
-            f.close();
+        /**
+         * Ленивая загрузка: файл не читается сейчас, а загружается и проверяется
+         * при первом обращении через get()/operator-> (или update()), либо заранее
+         * в фоне через StorageManager::startPrefetch().
+         * В этом режиме обращаться к данным только через get()/operator->:
+         * до загрузки save() ничего не пишет, а update() сначала загружает файл
+         * @param resetFunc Функция для сброса данных при ошибке (как в load())
+         * @param prefetch Включить объект в список фоновой предзагрузки
+         */
+        void loadLazy(void (*resetFunc)(T&) = nullptr, bool prefetch = false) {
+            _lazyReset = resetFunc;
+            _lazyOk = false;
+            _prefetch = prefetch;
+            _lazyState = LAZY_PENDING;
+            ST_LOG(STORAGE_LOG_DEBUG, "FS: '%s' will be loaded on first access%s", 
+                _path, prefetch ? " (prefetch)" : "");
+        }
 
-            if (!ok) {
-                ST_LOG(STORAGE_LOG_ERROR, "FS: Read error from '%s'", _path);
-                if (resetFunc) resetFunc(_data);
-                save();
-                return false;
+        /**
+         * Загрузить объект, если он ещё ждет ленивой загрузки.
+         * Если его сейчас грузит другая задача (предзагрузка) - дождаться её
+         * @return Результат загрузки (true и для объектов без ленивой загрузки)
+         */
+        bool ensureLoaded() {
+            if (_lazyState == LAZY_DONE) return _lazyOk;
+            portENTER_CRITICAL(&_lazyMux);
+            bool mine = _lazyState == LAZY_PENDING;
+            if (mine) _lazyState = LAZY_LOADING;
+            portEXIT_CRITICAL(&_lazyMux);
+            if (!mine) {
+                while (_lazyState == LAZY_LOADING) vTaskDelay(1);
+                return _lazyOk;
             }
+            _lazyOk = loadFile(_lazyReset);
+            _lazyState = LAZY_DONE;
+            return _lazyOk;
+        }
 
-            uint32_t calcCrc = crc32_le(0, (const uint8_t*)&_data, sizeof(T));
-            if (calcCrc != storedCrc) {
-                ST_LOG(STORAGE_LOG_ERROR, "FS: CRC error in '%s' (stored: 0x%08X, calc: 0x%08X)", 
-                    _path, storedCrc, calcCrc);
-                if (resetFunc) resetFunc(_data);
-                save();
-                return false;
-            }
-            
-            ST_LOG(STORAGE_LOG_INFO, "FS: '%s' loaded OK (size: %u, CRC: 0x%08X)", 
-                _path, sizeof(T), calcCrc);
-            return true;
+        /**
+         * Доступ к данным с ленивой загрузкой при первом обращении
+         * @return Ссылка на данные
+         */
+        T& get() {
+            ensureLoaded();
+            return _data;
+        }
+
+        T* operator->() {
+            return &get();
         }
 
         /**
-         * Непосредственная запись файла
-         * @return true если файл записан успешно
+         * @return true если объект уже загружен (или ленивая загрузка не включена)
+         */
+        bool isLoaded() const {
+            return _lazyState == LAZY_DONE;
+        }
+
+        /**
+         * Непосредственная запись файла.
+         * С блокирующей политикой данные копируются в снимок под коротким захватом,
+         * а контрольная сумма и запись идут уже без блокировки.
+         * Во время OTA запись откладывается: данные остаются помеченными
+         * и пишутся в StorageManager::setOtaRunning(false)
+         * @return true если файл записан успешно или отложен до конца OTA
          */
         bool save() {
     #ifdef STORAGE_CHECK_OTA
-            if (_otaRunning) {
-                ST_LOG(STORAGE_LOG_WARNING, "FS: Blocked by OTA for '%s'", _path);
-                return false;
+            if (StorageManager::isOtaRunning()) {
+                _lock.lock();
+                _isDirty = true;
+                _lock.unlock();
+                StorageManager::deferForOta(_path);
+                ST_METRIC(_metrics.m.throttled++);
+                return true;
             }
     #endif
-            if (!_fsMounted) {
-                ST_LOG(STORAGE_LOG_ERROR, "FS: Filesystem not mounted for '%s'", _path);
-                return false;
-            }
-            
-            if (!hasSpace()) {
-                return false;
+            if (_lazyState == LAZY_PENDING) return true;  // не загружен - писать нечего
+            if (_rtc && !_writeFn) {
+                _lock.lock();
+                bool due = _rtc->store(_data, _rtcForce ? 1 : _rtcEvery);
+                _rtcForce = false;
+                if (!due) _isDirty = false;
+                _lock.unlock();
+                if (!due) {
+                    ST_LOG(STORAGE_LOG_DEBUG, "FS: '%s' kept in RTC (%u saves not in flash)", _path, _rtc->cycles);
+                    ST_METRIC(_metrics.m.skipped++);
+                    return true;
+                }
             }
+            if (!mounted()) return false;
 
-            File f = LittleFS.open(_path, "w");
-            if (!f) {
-                ST_LOG(STORAGE_LOG_ERROR, "FS: Can't write '%s'", _path);
-                return false;
+            _lock.lock();
+            uint32_t seq = _changeSeq;
+            const uint8_t* src = takeSnapshot();
+            bool holdLock = !src;     // снимка нет - пишем прямо из _data, не отпуская блокировку
+            if (!src) src = (const uint8_t*)&_data;
+
+            size_t planned = pendingBytes();  // для оценки времени записи
+            // Какие блоки писать: забираем карту, новые update() во время записи наполнят её заново
+            uint8_t bits[sizeof(_dirtyBlocks)];
+            if (!_blocksValid) memset(_dirtyBlocks, 0xFF, sizeof(_dirtyBlocks));
+            memcpy(bits, _dirtyBlocks, sizeof(bits));
+            memset(_dirtyBlocks, 0, sizeof(_dirtyBlocks));
+            if (!holdLock) _lock.unlock();
+
+            uint32_t crc = 0;
+            size_t written = 0;
+            int64_t start = esp_timer_get_time();
+            bool ok = writeFile(src, bits, crc, written);
+            uint32_t us = (uint32_t)(esp_timer_get_time() - start);
+            ST_METRIC(_metrics.m.save.add(us));
+            if (ok) noteWrite(us, planned);
+
+            if (!holdLock) _lock.lock();
+            if (ok) {
+                if (_changeSeq == seq) _isDirty = false;  // иначе пока писали, пришёл новый update()
+                if (blockMode()) _blocksValid = true;
+            } else {
+                // Незаписанные блоки остаются помеченными, остальные файлы блоков не тронуты
+                for (size_t i = 0; i < sizeof(bits); i++) _dirtyBlocks[i] |= bits[i];
+                ST_METRIC(_metrics.m.failures++);
             }
-            
-            uint32_t crc = crc32_le(0, (const uint8_t*)&_data, sizeof(T));
-            size_t writtenCrc = f.write((uint8_t*)&crc, 4);
-            size_t writtenData = f.write((uint8_t*)&_data, sizeof(T));
-            f.close();
-            
-            if (writtenCrc != 4 || writtenData != sizeof(T)) {
-                ST_LOG(STORAGE_LOG_ERROR, "FS: Write error for '%s'", _path);
-                return false;
+            _lock.unlock();
+
+            if (ok) {
+                ST_METRIC(_metrics.m.bytesWritten += written);
+                if (_rtc && !_writeFn) _rtc->markWritten();
+                ST_LOG(STORAGE_LOG_INFO, "FS: '%s' saved (size: %u of %u, CRC: 0x%08X)", 
+                    _path, written, sizeof(T), crc);
             }
-            
-            _isDirty = false;
-            ST_LOG(STORAGE_LOG_INFO, "FS: '%s' saved (size: %u, CRC: 0x%08X)", 
-                _path, sizeof(T), crc);
-            return true;
+            return ok;
         }
 
         /**
          * Пометить данные как измененные
          */
         void update() {
+            update(0, sizeof(T));
+        }
+
+        /**
+         * Пометить изменённым диапазон байт объекта.
+         * В блочном режиме запишутся только задетые блоки, иначе - весь объект
+         * @param offset Смещение от начала объекта
+         * @param len Длина диапазона
+         */
+        void update(size_t offset, size_t len) {
+            ensureLoaded();  // иначе незагруженный объект перезаписал бы файл
+            _lock.lock();
+            markBlocks(offset, len);
             _isDirty = true;
+            _changeSeq++;
             _lastChangeTime = millis();
+            _lock.unlock();
             
             if (!_debounceEnabled) {
-                save();
+                requestSave();
+            } else {
+                StorageManager::schedule(deadline());
+            }
+        }
+
+        /**
+         * Пометить изменённым одно поле объекта
+         * @code
+         * myLog.temps[5] = 21.5f;
+         * fsLog.updateField(myLog.temps[5]);
+         * @endcode
+         * @param field Ссылка на поле внутри связанной структуры
+         */
+        template <typename F>
+        void updateField(const F& field) {
+            const uint8_t* p = (const uint8_t*)&field;
+            const uint8_t* base = (const uint8_t*)&_data;
+            if (p < base || p + sizeof(F) > base + sizeof(T)) {
+                ST_LOG(STORAGE_LOG_WARNING, "FS: Field outside of '%s', marking whole object", _path);
+                update();
+                return;
             }
+            update(p - base, sizeof(F));
         }
 
         /**
-         * Проверка таймера отложенной записи
+         * Проверка таймера отложенной записи.
+         * Для множества объектов удобнее один StorageManager::tick()
          */
-        void tick() {
-            if (!_debounceEnabled || !_isDirty) return;
+        void tick() override {
+            if (!_debounceEnabled || !_isDirty || _queued) return;
+    #ifdef STORAGE_CHECK_OTA
+            if (StorageManager::isOtaRunning()) return;
+    #endif
             
             uint32_t currentTime = millis();
-            uint32_t elapsed = (currentTime >= _lastChangeTime) 
-                ? (currentTime - _lastChangeTime) 
-                : (UINT32_MAX - _lastChangeTime + currentTime);
+            _lock.lock();
+            uint32_t lastChange = _lastChangeTime;
+            _lock.unlock();
+            uint32_t elapsed = (currentTime >= lastChange) 
+                ? (currentTime - lastChange) 
+                : (UINT32_MAX - lastChange + currentTime);
             
             if (elapsed >= _intervalMs) {
                 ST_LOG(STORAGE_LOG_DEBUG, "FS: Debounce timeout for '%s' (elapsed: %u ms)", 
                     _path, elapsed);
-                save();
+                requestSave();
             }
         }
 
@@ -191,7 +1247,7 @@
          * Принудительное сохранение
          * @return true если данные сохранены
          */
-        bool flush() {
+        bool flush() override {
             if (_isDirty) {
                 return save();
             }
@@ -199,11 +1255,42 @@
         }
 
         /**
-         * Проверка существования файла
+         * Дописать изменения и дождаться окончания записи (для выключения/перезагрузки).
+         * При фоновой записи ждёт задачу-писателя, иначе пишет сразу
+         * @param timeoutMs Максимальное время ожидания фоновой записи
+         * @return true если несохраненных изменений не осталось
+         */
+        bool flushAndWait(uint32_t timeoutMs) {
+            if (!_isDirty) return true;
+            if (!_background || !StorageWriter::isRunning()) return save();
+            requestSave();
+            StorageWriter::waitIdle(timeoutMs);
+            return !_isDirty;
+        }
+
+        /**
+         * Включить/отключить фоновую запись: tick()/update() только ставят задание
+         * в очередь StorageWriter, а файл пишется в отдельной задаче.
+         * Задача запускается с настройками по умолчанию, если ещё не запущена
+         * (для выбора ядра вызвать StorageWriter::begin(core) заранее)
+         * @param enabled true для записи в фоне
+         * @param onSaved Вызывается из задачи-писателя после каждой записи (может быть nullptr)
+         */
+        void setBackgroundWrite(bool enabled, void (*onSaved)(const char* path, bool ok) = nullptr) {
+            _onSaved = onSaved;
+            _background = enabled && StorageWriter::begin();
+            ST_LOG(STORAGE_LOG_DEBUG, "FS: Background write for '%s' %s", 
+                _path, _background ? "enabled" : "disabled");
+        }
+
+        /**
+         * Проверка существования файла (в блочном режиме - файла первого блока или
+         * файла обычного формата)
          * @return true если файл существует
          */
         bool exists() {
-            if (!_fsMounted) return false;
+            if (!mounted()) return false;
+            if (blockMode() && LittleFS.exists(blockPath(0).c_str())) return true;
             return LittleFS.exists(_path);
         }
 
@@ -212,8 +1299,29 @@
          * @return true если файл удалён
          */
         bool remove() {
-            if (!_fsMounted) return false;
-            bool success = LittleFS.remove(_path);
+            if (!mounted()) return false;
+            if (LittleFS.exists(_tmpPath.c_str())) LittleFS.remove(_tmpPath.c_str());
+            bool success = true;
+            if (blockMode()) {
+                // Сначала запись фиксации: без неё временные файлы блоков уже ничего не значат
+                bool found = false;
+                auto drop = [&](const char* path, size_t size) {
+                    if (!LittleFS.exists(path)) return;
+                    found = true;
+                    success = StorageManager::removeFile(path, size) && success;
+                };
+                drop(commitPath().c_str(), StorageManager::UNKNOWN_SIZE);
+                for (size_t i = 0; i < BLOCK_COUNT; i++) {
+                    drop(blockTmpPath(i).c_str(), StorageManager::UNKNOWN_SIZE);
+                    drop(blockPath(i).c_str(), _blocksValid ? blockFileSize(i) : StorageManager::UNKNOWN_SIZE);
+                }
+                drop(_path, _fileSize);
+                success = success && found;
+            } else {
+                success = StorageManager::removeFile(_path, _fileSize);
+            }
+            _fileSize = success ? 0 : StorageManager::UNKNOWN_SIZE;
+            _blocksValid = false;
             if (success) {
                 _isDirty = false;
                 ST_LOG(STORAGE_LOG_INFO, "FS: File '%s' removed", _path);
@@ -223,6 +1331,17 @@
             return success;
         }
 
+        /**
+         * Захватить данные объекта (с StorageNoLock ничего не делает).
+         * Изменения _data из других задач делать под захватом, например через StorageLockGuard
+         */
+        void lock() { _lock.lock(); }
+
+        /**
+         * Отпустить данные объекта
+         */
+        void unlock() { _lock.unlock(); }
+
         /**
          * Включить/отключить отложенную запись
          * @param enabled true для включения дебаунса
@@ -233,19 +1352,182 @@
                 _path, enabled ? "enabled" : "disabled");
         }
 
+        /**
+         * Включить/отключить атомарную запись (временный файл + rename).
+         * Без неё save() перезаписывает единственную копию на месте
+         * @param enabled true для записи через временный файл
+         */
+        void setAtomicSave(bool enabled) {
+            _atomicSave = enabled;
+            ST_LOG(STORAGE_LOG_DEBUG, "FS: Atomic save for '%s' %s", 
+                _path, enabled ? "enabled" : "disabled");
+        }
+
+        /**
+         * Включить/отключить блочный режим хранения (вызывать до load()).
+         * Объект делится на блоки по STORAGE_FS_DELTA_BLOCK байт, каждый в своем файле
+         * "<path>.<N>" со своим заголовком и суммой, и save() переписывает только файлы блоков,
+         * помеченных update(offset, len)/updateField(), - на флеш уходят эти блоки и
+         * запись фиксации в несколько байт, а не весь объект.
+         * Несколько блоков фиксируются файлом "<path>.commit": после сбоя питания load()
+         * возвращает прежнюю или новую версию целиком.
+         * Каждый файл занимает отдельный блок LittleFS, если не помещается в метаданные
+         * (см. STORAGE_FS_DELTA_BLOCK), так что размер блока - компромисс между
+         * объемом записи и местом на флеше. Файл обычного формата читается один раз и
+         * удаляется после первой записи блоков. Сжатие (Codec) в блочном режиме не применяется
+         * @param enabled true для блочного режима
+         */
+        void setDeltaSave(bool enabled) {
+            _deltaSave = enabled;
+            _blocksValid = false;
+            ST_LOG(STORAGE_LOG_DEBUG, "FS: Delta save for '%s' %s (%u blocks of %u)", 
+                _path, enabled ? "enabled" : "disabled", (uint32_t)BLOCK_COUNT, (uint32_t)BLOCK_SIZE);
+        }
+
+        /**
+         * Размер куска потокового чтения/записи (по умолчанию STORAGE_FS_CHUNK_SIZE)
+         * @param bytes Размер куска в байтах
+         */
+        void setChunkSize(size_t bytes) {
+            _chunkSize = bytes ? bytes : STORAGE_FS_CHUNK_SIZE;
+        }
+
+        /**
+         * Промежуточный буфер загрузки: load() читает и проверяет данные в нём,
+         * а в _data копирует только после совпадения суммы - при битом файле
+         * _data не остается наполовину перезаписанным.
+         * Без него load() берет временный буфер из кучи для объектов до
+         * STORAGE_FS_STAGED_LOAD_MAX байт; больший объект (или нет RAM) читается прямо
+         * в _data и при ошибке получает resetFunc, а без неё - нули.
+         * Для больших объектов удобно выделить в PSRAM: ps_malloc(sizeof(T))
+         * @param buffer Буфер не меньше sizeof(T) байт (nullptr - временный буфер или прямо в _data)
+         */
+        void setLoadBuffer(void* buffer) {
+            _loadBuffer = (uint8_t*)buffer;
+        }
+
+        /**
+         * Пользовательская сериализация для объектов, которые нельзя писать байтами
+         * (указатели, String, контейнеры). Пишется/читается потоком с суммой по ходу.
+         * Блочный режим и снимок без блокировки для таких объектов не используются
+         * @code
+         * bool writeCfg(const Cfg& c, StorageOutStream& out) {
+         *     uint16_t n = c.name.length();
+         *     return out.put(n) && out.write(c.name.c_str(), n) && out.put(c.port);
+         * }
+         * @endcode
+         * @param writeFn Запись объекта в поток
+         * @param readFn Чтение объекта из потока (должно прочитать ровно то, что записано)
+         */
+        void setSerializer(bool (*writeFn)(const T& obj, StorageOutStream& out),
+                           bool (*readFn)(T& obj, StorageInStream& in)) {
+            _writeFn = writeFn;
+            _readFn = readFn;
+        }
+
+        /**
+         * Версия схемы данных, записывается в заголовок файла (вызывать до load()).
+         * Файл другой версии проводится по цепочке миграций в RAM и перезаписывается
+         * обычным порядком, по истечении дебаунса. Файлы прежнего формата (без заголовка)
+         * и файлы, записанные без setVersion(), имеют версию 0.
+         * Миграция работает для объектов, которые пишутся байтами; файлы блоков
+         * (setDeltaSave) должны быть текущей версии
+         * @param version Текущая версия
+         * @param migrations Цепочка миграций (объект должен жить, пока живет хранилище; nullptr - без миграций)
+         */
+        void setVersion(uint8_t version, const StorageMigrations* migrations = nullptr) {
+            _version = version;
+            _migrations = migrations;
+        }
+
+        /**
+         * Загрузка при изменившемся размере T (вызывать до load()): из файла большего
+         * или меньшего размера берется общий префикс, хвост заполняется resetFunc из load()
+         * (или остается как был). Полная структура записывается обратно после дебаунса.
+         * Подходит, когда поля только дописываются в конец структуры
+         * @param enabled true для загрузки общего префикса
+         */
+        void setSizeTolerant(bool enabled) {
+            _sizeTolerant = enabled;
+            ST_LOG(STORAGE_LOG_DEBUG, "FS: Size tolerant load for '%s' %s", 
+                _path, enabled ? "enabled" : "disabled");
+        }
+
+#ifdef STORAGE_METRICS
+        /**
+         * Счетчики файла (-D STORAGE_METRICS)
+         */
+        const StorageMetrics& getMetrics() const { return _metrics.m; }
+
+        /**
+         * Обнулить счетчики файла
+         */
+        void resetMetrics() { _metrics.m = StorageMetrics(); }
+#endif
+
+        /**
+         * RTC-копия для устройств с deep sleep (вызывать до load()): после пробуждения
+         * load() берет данные из RTC-памяти без чтения файла, а save() пишет файл
+         * только раз в writeEvery сохранений с изменениями (остальные - только в RTC).
+         * Для объектов с сериализатором не действует
+         * @code
+         * RTC_NOINIT_ATTR StorageRtcShadow<BigData> bigShadow;
+         * fsBig.setRtcShadow(&bigShadow, 10);
+         * @endcode
+         * @param shadow RTC-копия (nullptr - отключить)
+         * @param writeEvery Раз во сколько сохранений писать файл
+         */
+        void setRtcShadow(StorageRtcShadow<T, Checksum>* shadow, uint16_t writeEvery = STORAGE_RTC_WRITE_EVERY) {
+            _rtc = shadow;
+            _rtcEvery = writeEvery;
+        }
+
+        /**
+         * Записать файл сейчас, даже если RTC-копия ещё не набрала writeEvery сохранений
+         * (перед выключением питания, OTA)
+         * @return true если файл записан
+         */
+        bool writeThrough() {
+            _rtcForce = true;
+            return save();
+        }
+
+        /**
+         * @return Текущая версия схемы данных
+         */
+        uint8_t getVersion() const {
+            return _version;
+        }
+
         /**
          * Получить статус изменений
          * @return true если есть несохраненные изменения
          */
-        bool isDirty() const {
+        bool isDirty() const override {
             return _isDirty;
         }
 
+        /**
+         * @return true если есть изменения или сохранения, оставшиеся только в RTC-копии
+         */
+        bool unflushed() const override {
+            return _isDirty || (_rtc && !_writeFn && _rtc->valid() && _rtc->pending);
+        }
+
+        /**
+         * Записать во флеш всё, чего там нет (с RTC-копией - через writeThrough())
+         * @return true если во флеше актуальные данные
+         */
+        bool flushToFlash() override {
+            if (!unflushed()) return true;
+            return _rtc && !_writeFn ? writeThrough() : save();
+        }
+
         /**
          * Получить путь к файлу
          * @return Путь к файлу
          */
-        const char* getPath() const {
+        const char* getPath() const override {
             return _path;
         }
 
@@ -256,6 +1538,13 @@
         uint32_t getDebounceInterval() const {
             return _intervalMs;
         }
+
+        /**
+         * Момент (millis), когда истекает дебаунс текущих изменений
+         */
+        uint32_t deadline() const override {
+            return _lastChangeTime + _intervalMs;
+        }
     };
 
 
@@ -0,0 +1,134 @@
+#ifndef BSY_UNISTOR_B_LITTLEFS_WRITER_PART_H
+#define BSY_UNISTOR_B_LITTLEFS_WRITER_PART_H
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+
+    /**
+     * @struct StorageWriteJob
+     * @brief Задание фоновому писателю: объект и функция, выполняющая его запись
+     */
+    struct StorageWriteJob {
+        void* owner;
+        bool (*run)(void* owner);
+    };
+
+    /**
+     * @class StorageWriter
+     * @brief Фоновая FreeRTOS-задача, которая выполняет запись файлов вместо loop()
+     *
+     * Одна задача на всю библиотеку. Объекты StorageBigAkaFileSys с включенной
+     * фоновой записью кладут в её очередь задание, а сама запись во флеш
+     * выполняется в задаче на выбранном ядре.
+     */
+    class StorageWriter {
+    private:
+        inline static QueueHandle_t _queue = nullptr;
+        inline static TaskHandle_t _task = nullptr;
+        inline static SemaphoreHandle_t _ioMutex = nullptr;
+        inline static volatile uint32_t _inFlight = 0;   // в очереди + выполняется
+        inline static portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+
+        static void taskLoop(void*) {
+            StorageWriteJob job;
+            for (;;) {
+                if (xQueueReceive(_queue, &job, portMAX_DELAY) != pdTRUE) continue;
+                job.run(job.owner);
+                portENTER_CRITICAL(&_mux);
+                _inFlight--;
+                portEXIT_CRITICAL(&_mux);
+            }
+        }
+
+    public:
+        /**
+         * Запуск задачи-писателя (повторный вызов ничего не делает)
+         * @param core Ядро, к которому привязана задача (tskNO_AFFINITY - любое)
+         * @param priority Приоритет задачи
+         * @param stackSize Размер стека в байтах
+         * @return true если задача работает
+         */
+        static bool begin(BaseType_t core = STORAGE_WRITER_CORE,
+                          UBaseType_t priority = STORAGE_WRITER_PRIORITY,
+                          uint32_t stackSize = STORAGE_WRITER_STACK) {
+            if (_task) return true;
+
+            if (!_ioMutex) _ioMutex = xSemaphoreCreateMutex();
+            if (!_queue) _queue = xQueueCreate(STORAGE_WRITER_QUEUE_LEN, sizeof(StorageWriteJob));
+            if (!_queue || !_ioMutex) {
+                ST_LOG(STORAGE_LOG_ERROR, "FS: Writer task: out of memory");
+                return false;
+            }
+
+            if (xTaskCreatePinnedToCore(taskLoop, "storage_wr", stackSize, nullptr,
+                                        priority, &_task, core) != pdPASS) {
+                _task = nullptr;
+                ST_LOG(STORAGE_LOG_ERROR, "FS: Writer task create failed");
+                return false;
+            }
+            ST_LOG(STORAGE_LOG_INFO, "FS: Writer task started (core: %d, prio: %u)", (int)core, priority);
+            return true;
+        }
+
+        /**
+         * @return true если задача-писатель запущена
+         */
+        static bool isRunning() {
+            return _task != nullptr;
+        }
+
+        /**
+         * Поставить запись в очередь (не блокирует)
+         * @param owner Объект хранилища
+         * @param run Функция записи объекта
+         * @return true если задание принято
+         */
+        static bool enqueue(void* owner, bool (*run)(void*)) {
+            if (!_task) return false;
+            StorageWriteJob job = { owner, run };
+            portENTER_CRITICAL(&_mux);
+            _inFlight++;
+            portEXIT_CRITICAL(&_mux);
+            if (xQueueSend(_queue, &job, 0) != pdTRUE) {
+                portENTER_CRITICAL(&_mux);
+                _inFlight--;
+                portEXIT_CRITICAL(&_mux);
+                ST_LOG(STORAGE_LOG_WARNING, "FS: Writer queue full");
+                return false;
+            }
+            return true;
+        }
+
+        /**
+         * Дождаться, пока задача допишет всё, что стоит в очереди
+         * @param timeoutMs Максимальное время ожидания
+         * @return true если очередь опустела
+         */
+        static bool waitIdle(uint32_t timeoutMs) {
+            TickType_t start = xTaskGetTickCount();
+            while (_inFlight) {
+                if ((xTaskGetTickCount() - start) * portTICK_PERIOD_MS >= timeoutMs) return false;
+                vTaskDelay(1);
+            }
+            return true;
+        }
+
+        /**
+         * @class IoGuard
+         * @brief Не даёт задаче и loop() одновременно писать файлы
+         * (пока задача не запущена - ничего не блокирует)
+         */
+        class IoGuard {
+        private:
+            bool _locked;
+        public:
+            IoGuard() : _locked(_ioMutex && xSemaphoreTake(_ioMutex, portMAX_DELAY) == pdTRUE) {}
+            ~IoGuard() { if (_locked) xSemaphoreGive(_ioMutex); }
+            IoGuard(const IoGuard&) = delete;
+            IoGuard& operator=(const IoGuard&) = delete;
+        };
+    };
+
+
+#endif
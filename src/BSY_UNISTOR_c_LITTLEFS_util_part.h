@@ -17,9 +17,103 @@
      * @brief Сервисный класс для управления файловой системой
      */
     class StorageFS {
+    private:
+        inline static uint8_t* _copyBuf = nullptr;   // буфер setCopyBuffer()
+        inline static size_t _copyBufSize = 0;
+
+        /**
+         * Буфер копирования на время copyFile(): заданный setCopyBuffer() или из кучи
+         */
+        struct CopyBuffer {
+            uint8_t* data;
+            size_t size;
+            bool owned;
+
+            CopyBuffer() : data(_copyBuf), size(_copyBufSize), owned(false) {
+                if (data) return;
+                size = STORAGE_FS_COPY_BUFFER;
+                data = new (std::nothrow) uint8_t[size];
+                owned = true;
+            }
+            ~CopyBuffer() { if (owned) delete[] data; }
+            CopyBuffer(const CopyBuffer&) = delete;
+            CopyBuffer& operator=(const CopyBuffer&) = delete;
+        };
+
+        /**
+         * Путь элемента директории (name() в разных версиях ядра - имя или полный путь)
+         */
+        static String childPath(const char* dir, const char* name) {
+            const char* base = strrchr(name, '/');
+            base = base ? base + 1 : name;
+            String path(dir);
+            if (!path.endsWith("/")) path += "/";
+            return path + base;
+        }
+
+        /**
+         * Обход директории с путем в общем буфере на стеке (path[0..len) - путь директории)
+         * @return false если обработчик попросил остановиться
+         */
+        static bool walk(char* path, size_t len, bool (*fn)(const char*, size_t, bool, void*),
+                         void* ctx, bool recursive) {
+            File dir = LittleFS.open(path);
+            if (!dir || !dir.isDirectory()) {
+                ST_LOG(STORAGE_LOG_ERROR, "FS: Can't open directory '%s'", path);
+                return true;
+            }
+            bool go = true;
+            for (File f = dir.openNextFile(); f && go; f = dir.openNextFile()) {
+                const char* name = f.name();
+                const char* base = strrchr(name, '/');
+                base = base ? base + 1 : name;
+                size_t sep = (len && path[len - 1] == '/') ? 0 : 1;
+                size_t n = strlen(base);
+                if (len + sep + n >= STORAGE_FS_PATH_MAX) {
+                    ST_LOG(STORAGE_LOG_WARNING, "FS: Path too long in '%s', skipping '%s'", path, base);
+                    continue;
+                }
+                if (sep) path[len] = '/';
+                memcpy(path + len + sep, base, n + 1);
+
+                bool isDir = f.isDirectory();
+                size_t size = isDir ? 0 : f.size();
+                f.close();
+                go = fn(path, size, isDir, ctx);
+                if (go && isDir && recursive) go = walk(path, len + sep + n, fn, ctx, recursive);
+                path[len] = '\0';
+            }
+            dir.close();
+            return go;
+        }
+
+        /**
+         * CRC32 файла целиком
+         */
+        static bool fileCrc(const char* path, uint8_t* buf, size_t bufSize, uint32_t& crc) {
+            File f = LittleFS.open(path, "r");
+            if (!f) return false;
+            StorageCrc32 sum;
+            sum.begin();
+            size_t left = f.size();
+            while (left) {
+                size_t want = left < bufSize ? left : bufSize;
+                if (f.read(buf, want) != want) {
+                    f.close();
+                    return false;
+                }
+                sum.update(buf, want);
+                left -= want;
+            }
+            f.close();
+            crc = sum.finish();
+            return true;
+        }
+
     public:
         /**
-         * Инициализация LittleFS
+         * Инициализация LittleFS. Результат общий для всех StorageBigAkaFileSys,
+         * сами объекты повторно не монтируют
          * @param formatOnFail Форматировать при ошибке монтирования
          * @return true если файловая система инициализирована
          */
@@ -29,12 +123,14 @@
             if (!LittleFS.begin(false)) {
                 if (!formatOnFail) {
                     ST_LOG(STORAGE_LOG_ERROR, "FS: Mount failed");
+                    StorageManager::setMounted(false);
                     return false;
                 }
                 
                 ST_LOG(STORAGE_LOG_WARNING, "FS: Mount failed. Trying to format...");
                 if (!LittleFS.begin(true)) {
                     ST_LOG(STORAGE_LOG_ERROR, "FS: Format failed!");
+                    StorageManager::setMounted(false);
                     return false;
                 }
                 ST_LOG(STORAGE_LOG_INFO, "FS: Format successful.");
@@ -42,18 +138,21 @@
                 ST_LOG(STORAGE_LOG_INFO, "FS: Mount OK.");
             }
             
+            StorageManager::setMounted(true);
+            StorageManager::refreshStats();
             printStats();
             return true;
         }
 
         /**
-         * Получить статистику использования
+         * Получить статистику использования из кэша. Записи и удаления через библиотеку
+         * учитываются сразу (с точностью до блока STORAGE_FS_BLOCK), полный пересчет -
+         * раз в STORAGE_FS_STATS_MS или по refreshStats()
          * @return Структура со статистикой
          */
         static StorageStats getStats() {
             StorageStats stats;
-            stats.totalBytes = LittleFS.totalBytes();
-            stats.usedBytes = LittleFS.usedBytes();
+            StorageManager::fsStats(stats.totalBytes, stats.usedBytes);
             stats.freeBytes = (stats.totalBytes > stats.usedBytes) 
                 ? (stats.totalBytes - stats.usedBytes) 
                 : 0;
@@ -63,6 +162,15 @@
             return stats;
         }
 
+        /**
+         * Пересчитать статистику (после записи файлов в обход библиотеки)
+         * @return Структура со статистикой
+         */
+        static StorageStats refreshStats() {
+            StorageManager::refreshStats();
+            return getStats();
+        }
+
         /**
          * Вывод статистики в лог
          */
@@ -80,6 +188,7 @@
         static void fullResetFS() {
             ST_LOG(STORAGE_LOG_WARNING, "!!! FULL RESET STARTED !!!");
             
+            StorageManager::invalidateStats();
             if (LittleFS.format()) {
                 ST_LOG(STORAGE_LOG_INFO, "FS: LittleFS formatted OK.");
             } else {
@@ -92,51 +201,155 @@
         }
 
         /**
-         * Создание резервной копии файла
+         * Создание резервной копии файла (через copyFile, с проверкой)
          * @param srcPath Исходный файл
          * @param backupPath Файл для резервной копии (если nullptr, будет создан с .bak)
          * @return true если резервная копия создана
          */
         static bool backupFile(const char* srcPath, const char* backupPath = nullptr) {
-            if (!backupPath) {
-                backupPath = (String(srcPath) + ".bak").c_str();
-            }
-            
-            if (LittleFS.exists(backupPath)) {
-                LittleFS.remove(backupPath);
-            }
-            
+            String path = backupPath ? String(backupPath) : String(srcPath) + ".bak";
+            return copyFile(srcPath, path.c_str());
+        }
+
+        /**
+         * Копирование файла кусками по STORAGE_FS_COPY_BUFFER (или буфером setCopyBuffer).
+         * Копия пишется во временный "<dstPath>.tmp" и только после проверки
+         * заменяет dstPath - прежняя копия не теряется при сбое
+         * @param srcPath Исходный файл
+         * @param dstPath Куда копировать (существующий файл заменяется)
+         * @param verify Перечитать копию и сверить CRC32 с исходным файлом
+         * @return true если копия записана полностью (и совпала)
+         */
+        static bool copyFile(const char* srcPath, const char* dstPath, bool verify = true) {
+            StorageWriter::IoGuard io;
+            uint32_t start = millis();
+
             File src = LittleFS.open(srcPath, "r");
-            if (!src) {
+            if (!src || src.isDirectory()) {
                 ST_LOG(STORAGE_LOG_ERROR, "FS: Can't open source file '%s'", srcPath);
                 return false;
             }
-            
-            File dst = LittleFS.open(backupPath, "w");
+            size_t size = src.size();
+            if (getFreeSpace() < size + 512) {
+                src.close();
+                ST_LOG(STORAGE_LOG_ERROR, "FS: Low space to copy '%s' (%u bytes)", srcPath, size);
+                return false;
+            }
+
+            CopyBuffer buf;
+            if (!buf.data) {
+                src.close();
+                ST_LOG(STORAGE_LOG_ERROR, "FS: No RAM for copy buffer (%u bytes)", buf.size);
+                return false;
+            }
+
+            String tmp = String(dstPath) + ".tmp";
+            size_t oldSize = StorageManager::statsValid() ? StorageManager::fileSize(dstPath) : 0;
+            File dst = LittleFS.open(tmp.c_str(), "w");
             if (!dst) {
                 src.close();
-                ST_LOG(STORAGE_LOG_ERROR, "FS: Can't create backup file '%s'", backupPath);
+                ST_LOG(STORAGE_LOG_ERROR, "FS: Can't create file '%s'", tmp.c_str());
                 return false;
             }
-            
-            uint8_t buffer[512];
+
+            StorageCrc32 sum;
+            sum.begin();
             size_t total = 0;
-            while (src.available()) {
-                size_t len = src.read(buffer, sizeof(buffer));
-                dst.write(buffer, len);
+            bool ok = true;
+            while (ok && total < size) {
+                size_t want = size - total < buf.size ? size - total : buf.size;
+                size_t len = src.read(buf.data, want);
+                sum.update(buf.data, len);
+                ok = len == want && dst.write(buf.data, len) == len;
                 total += len;
             }
-            
             src.close();
             dst.close();
-            
-            ST_LOG(STORAGE_LOG_INFO, "FS: Backup created '%s' -> '%s' (%u bytes)", 
-                srcPath, backupPath, total);
+
+            uint32_t crc = sum.finish();
+            if (ok && verify) {
+                uint32_t check;
+                ok = fileCrc(tmp.c_str(), buf.data, buf.size, check) && check == crc;
+            }
+            if (!ok) {
+                LittleFS.remove(tmp.c_str());
+                StorageManager::invalidateStats();
+                ST_LOG(STORAGE_LOG_ERROR, "FS: Copy '%s' -> '%s' failed at %u of %u bytes%s", 
+                    srcPath, dstPath, total, size, total == size ? " (verify)" : "");
+                return false;
+            }
+
+            if (!LittleFS.rename(tmp.c_str(), dstPath)) {
+                LittleFS.remove(dstPath);
+                if (!LittleFS.rename(tmp.c_str(), dstPath)) {
+                    ST_LOG(STORAGE_LOG_ERROR, "FS: Can't rename '%s' -> '%s'", tmp.c_str(), dstPath);
+                    StorageManager::invalidateStats();
+                    return false;
+                }
+            }
+            StorageManager::noteFileSize(oldSize, total);
+            ST_LOG(STORAGE_LOG_INFO, "FS: Copied '%s' -> '%s' (%u bytes, CRC: 0x%08X, %u ms)", 
+                srcPath, dstPath, total, crc, millis() - start);
             return true;
         }
 
+        /**
+         * Снимок директории: копирует все файлы (и поддиректории) srcDir в dstDir.
+         * Временные файлы ".tmp" пропускаются, dstDir внутри srcDir не копируется
+         * @param srcDir Исходная директория
+         * @param dstDir Директория снимка (создается при необходимости)
+         * @param verify Сверять CRC32 каждой копии
+         * @return true если скопированы все файлы
+         */
+        static bool snapshotDir(const char* srcDir, const char* dstDir, bool verify = true) {
+            File root = LittleFS.open(srcDir);
+            if (!root || !root.isDirectory()) {
+                ST_LOG(STORAGE_LOG_ERROR, "FS: Can't open directory '%s'", srcDir);
+                return false;
+            }
+            // Сначала список, потом копирование: новые файлы не попадают в обход
+            std::vector<String> files, dirs;
+            for (File f = root.openNextFile(); f; f = root.openNextFile()) {
+                String path = childPath(srcDir, f.name());
+                if (f.isDirectory()) dirs.push_back(path);
+                else if (!path.endsWith(".tmp")) files.push_back(path);
+            }
+            root.close();
+
+            if (!LittleFS.exists(dstDir) && !LittleFS.mkdir(dstDir)) {
+                ST_LOG(STORAGE_LOG_ERROR, "FS: Can't create directory '%s'", dstDir);
+                return false;
+            }
+
+            bool ok = true;
+            for (const String& path : files) {
+                String dst = childPath(dstDir, path.c_str());
+                ok &= copyFile(path.c_str(), dst.c_str(), verify);
+            }
+            for (const String& path : dirs) {
+                if (path == dstDir) continue;
+                String dst = childPath(dstDir, path.c_str());
+                ok &= snapshotDir(path.c_str(), dst.c_str(), verify);
+            }
+            ST_LOG(STORAGE_LOG_INFO, "FS: Snapshot '%s' -> '%s' (%u files) %s", 
+                srcDir, dstDir, (uint32_t)files.size(), ok ? "OK" : "with errors");
+            return ok;
+        }
+
+        /**
+         * Свой буфер копирования вместо выделения в куче на каждый copyFile()
+         * (например, статический или в PSRAM). Используется под StorageWriter::IoGuard
+         * @param buffer Буфер (nullptr - снова выделять STORAGE_FS_COPY_BUFFER в куче)
+         * @param size Размер буфера в байтах
+         */
+        static void setCopyBuffer(void* buffer, size_t size) {
+            _copyBuf = buffer ? (uint8_t*)buffer : nullptr;
+            _copyBufSize = buffer ? size : 0;
+        }
+
         /**
          * Получение списка файлов в директории
+         * (выделяет String на каждый файл; для больших директорий - forEachFile())
          * @param path Путь к директории (по умолчанию корень)
          * @return Вектор с именами файлов
          */
@@ -159,6 +372,49 @@
             return files;
         }
 
+        /**
+         * Обход директории без выделения памяти: имя, размер и тип каждого элемента
+         * берутся из самого обхода, файлы повторно не открываются
+         * @code
+         * bool onFile(const char* path, size_t size, bool isDir, void* ctx) {
+         *     if (!isDir && size > 100000) LittleFS.remove(path);
+         *     return true;  // false - остановить обход
+         * }
+         * StorageFS::forEachFile("/logs", onFile);
+         * @endcode
+         * @param path Путь к директории
+         * @param fn Обработчик: полный путь, размер (для директорий 0), признак директории, ctx
+         * @param ctx Произвольный указатель, передаётся в обработчик
+         * @param recursive Заходить в поддиректории (обработчик видит директорию до её содержимого)
+         * @return false если обход остановлен обработчиком
+         */
+        static bool forEachFile(const char* path, bool (*fn)(const char* path, size_t size, bool isDir, void* ctx),
+                                void* ctx = nullptr, bool recursive = false) {
+            char buf[STORAGE_FS_PATH_MAX];
+            size_t len = strlen(path);
+            if (len >= sizeof(buf)) {
+                ST_LOG(STORAGE_LOG_ERROR, "FS: Path too long '%s'", path);
+                return false;
+            }
+            memcpy(buf, path, len + 1);
+            return walk(buf, len, fn, ctx, recursive);
+        }
+
+        /**
+         * Суммарный размер файлов директории
+         * @param path Путь к директории
+         * @param recursive Учитывать поддиректории
+         * @return Размер в байтах
+         */
+        static size_t totalSize(const char* path = "/", bool recursive = true) {
+            size_t total = 0;
+            forEachFile(path, [](const char*, size_t size, bool, void* ctx) {
+                *static_cast<size_t*>(ctx) += size;
+                return true;
+            }, &total, recursive);
+            return total;
+        }
+
         /**
          * Получение информации о файле
          * @param path Путь к файлу
@@ -173,11 +429,11 @@
         }
 
         /**
-         * Получение свободного места
+         * Получение свободного места (из кэша статистики, см. getStats())
          * @return Свободное место в байтах
          */
         static size_t getFreeSpace() {
-            return LittleFS.totalBytes() - LittleFS.usedBytes();
+            return StorageManager::freeSpace();
         }
 
         /**
@@ -0,0 +1,337 @@
+#ifndef BSY_UNISTOR_D_LITTLEFS_RINGLOG_PART_H
+#define BSY_UNISTOR_D_LITTLEFS_RINGLOG_PART_H
+
+    /**
+     * @class StorageRingLog
+     * @brief Кольцевой журнал записей фиксированного размера в LittleFS
+     *
+     * Записи дописываются в конец текущего сегмента ("<base>.0" ... "<base>.N-1"),
+     * у каждой своя контрольная сумма. Когда сегмент заполнен, самый старый
+     * сегмент стирается и становится текущим. Добавление стоит O(размер записи),
+     * а не O(размер истории).
+     * @tparam R Тип записи (непрерывный блок памяти, как и для остальных хранилищ)
+     * @tparam Checksum Политика контрольной суммы (StorageCrc32, StorageXxHash32, ...)
+     */
+    template <typename R, typename Checksum = StorageCrc32>
+    class StorageRingLog {
+    private:
+        static constexpr uint32_t MAGIC = 0x474C5242;  // "BRLG"
+
+        #pragma pack(push, 1)
+        struct SegmentHeader {
+            uint32_t magic;
+            uint32_t seq;          // номер сегмента, растет при каждой ротации
+            uint16_t recordSize;   // sizeof(Slot), чтобы не читать записи другого типа
+            uint16_t reserved;
+        };
+
+        struct Slot {
+            R data;
+            uint32_t crc;
+        };
+        #pragma pack(pop)
+
+        const char* _base;
+        uint16_t _perSegment;
+        uint8_t _segments;
+        bool _ready = false;
+        uint8_t _head = 0;          // индекс текущего сегмента
+        uint32_t _headSeq = 0;
+        uint16_t _headCount = 0;    // записей в текущем сегменте
+        bool _headTorn = false;     // в хвосте текущего сегмента часть записи - дописывать нельзя
+        File _file;                 // текущий сегмент, открыт на дозапись
+
+        String segmentPath(uint8_t index) const {
+            return String(_base) + "." + String((unsigned)index);
+        }
+
+        /**
+         * Прочитать заголовок сегмента
+         * @param index Индекс сегмента
+         * @param hdr Куда положить заголовок
+         * @param records Сколько целых записей в сегменте
+         * @param torn true если в конце есть недописанная запись
+         * @return true если сегмент существует и заголовок валиден
+         */
+        bool readHeader(uint8_t index, SegmentHeader& hdr, uint16_t& records, bool& torn) {
+            String path = segmentPath(index);
+            File f = LittleFS.open(path.c_str(), "r");
+            if (!f) return false;
+            size_t size = f.size();
+            bool ok = f.read((uint8_t*)&hdr, sizeof(hdr)) == sizeof(hdr);
+            f.close();
+            if (!ok || hdr.magic != MAGIC || hdr.recordSize != sizeof(Slot)) return false;
+            size_t body = size - sizeof(hdr);
+            records = body / sizeof(Slot);
+            torn = (body % sizeof(Slot)) != 0;
+            return true;
+        }
+
+        /**
+         * Начать новый сегмент на месте самого старого
+         */
+        bool rotate() {
+            if (_file) _file.close();
+            _head = (_headSeq == 0) ? 0 : (_head + 1) % _segments;
+            _headSeq++;
+            _headCount = 0;
+            _headTorn = false;
+
+            String path = segmentPath(_head);
+            size_t oldSize = StorageManager::statsValid() ? StorageManager::fileSize(path.c_str()) : 0;
+            _file = LittleFS.open(path.c_str(), "w");
+            if (!_file) {
+                ST_LOG(STORAGE_LOG_ERROR, "FS: Can't create log segment '%s'", path.c_str());
+                return false;
+            }
+            SegmentHeader hdr = { MAGIC, _headSeq, (uint16_t)sizeof(Slot), 0 };
+            if (_file.write((uint8_t*)&hdr, sizeof(hdr)) != sizeof(hdr)) {
+                ST_LOG(STORAGE_LOG_ERROR, "FS: Write error for '%s'", path.c_str());
+                _file.close();
+                return false;
+            }
+            _file.flush();
+            StorageManager::noteFileSize(oldSize, sizeof(hdr));
+            ST_LOG(STORAGE_LOG_DEBUG, "FS: Log '%s' rotated to segment %u (seq: %u)",
+                _base, _head, _headSeq);
+            return true;
+        }
+
+        /**
+         * Записать слот в текущий сегмент
+         * @return true если записан целиком
+         */
+        bool writeSlot(const Slot& slot) {
+            if (_file.write((const uint8_t*)&slot, sizeof(Slot)) != sizeof(Slot)) return false;
+            _file.flush();
+            size_t size = sizeof(SegmentHeader) + (size_t)_headCount * sizeof(Slot);
+            StorageManager::noteFileSize(size, size + sizeof(Slot));
+            _headCount++;
+            return true;
+        }
+
+        /**
+         * Обход записей одного сегмента. Запись читается под IoGuard в локальный слот,
+         * обработчик вызывается уже без него
+         * @return false если обработчик попросил остановиться
+         */
+        bool walkSegment(uint8_t index, uint16_t records, bool reverse,
+                         bool (*fn)(const R& rec, void* ctx), void* ctx) {
+            String path = segmentPath(index);
+            File f;
+            {
+                StorageWriter::IoGuard io;
+                f = LittleFS.open(path.c_str(), "r");
+            }
+            if (!f) return true;
+            Slot slot;
+            for (uint16_t k = 0; k < records; k++) {
+                uint16_t i = reverse ? (records - 1 - k) : k;
+                bool ok;
+                {
+                    StorageWriter::IoGuard io;
+                    ok = f.seek(sizeof(SegmentHeader) + (size_t)i * sizeof(Slot))
+                        && f.read((uint8_t*)&slot, sizeof(Slot)) == sizeof(Slot);
+                }
+                if (!ok) break;  // сегмент стерт ротацией из обработчика
+                if (Checksum::calc(&slot.data, sizeof(R)) != slot.crc) {
+                    ST_LOG(STORAGE_LOG_WARNING, "FS: Bad record %u in '%s' skipped", i, path.c_str());
+                    continue;
+                }
+                if (!fn(slot.data, ctx)) {
+                    f.close();
+                    return false;
+                }
+            }
+            f.close();
+            return true;
+        }
+
+        /**
+         * Общий обход сегментов от старого к новому (или наоборот).
+         * Границы журнала фиксируются в начале: записи, добавленные обработчиком, не обходятся
+         */
+        void walk(bool reverse, bool (*fn)(const R& rec, void* ctx), void* ctx) {
+            if (!_ready) return;
+            uint8_t head = _head;
+            uint32_t headSeq = _headSeq;
+            uint16_t headCount = _headCount;
+            for (uint8_t k = 0; k < _segments; k++) {
+                // От текущего назад: head, head-1, ... ; для прямого порядка - наоборот
+                uint8_t back = reverse ? k : (_segments - 1 - k);
+                if (back >= headSeq) continue;
+                uint8_t index = (head + _segments - back) % _segments;
+                uint16_t records;
+                if (back == 0) {
+                    records = headCount;
+                } else {
+                    SegmentHeader hdr;
+                    bool torn, ok;
+                    {
+                        StorageWriter::IoGuard io;
+                        ok = readHeader(index, hdr, records, torn);
+                    }
+                    if (!ok || hdr.seq != headSeq - back) continue;
+                }
+                if (!walkSegment(index, records, reverse, fn, ctx)) return;
+            }
+        }
+
+    public:
+        /**
+         * Конструктор журнала
+         * @param baseName Базовый путь сегментов (например "/events")
+         * @param recordsPerSegment Записей в одном сегменте
+         * @param segments Количество сегментов (история = (segments-1..segments) * recordsPerSegment)
+         */
+        StorageRingLog(const char* baseName, uint16_t recordsPerSegment = 256, uint8_t segments = 4)
+            : _base(baseName), _perSegment(recordsPerSegment ? recordsPerSegment : 1),
+            _segments(segments < 2 ? 2 : segments) {}
+
+        /**
+         * Найти последний сегмент и открыть его на дозапись.
+         * Вызывать после StorageFS::begin()
+         * @return true если журнал готов к записи
+         */
+        bool begin() {
+            StorageWriter::IoGuard io;
+            _headSeq = 0;
+            bool torn = false;
+            for (uint8_t i = 0; i < _segments; i++) {
+                SegmentHeader hdr;
+                uint16_t records;
+                bool segTorn;
+                if (readHeader(i, hdr, records, segTorn) && hdr.seq > _headSeq) {
+                    _head = i;
+                    _headSeq = hdr.seq;
+                    _headCount = records;
+                    torn = segTorn;
+                }
+            }
+
+            // Недописанная запись в хвосте (сбой питания) - продолжим в новом сегменте,
+            // чтобы новые записи не легли со сдвигом
+            if (_headSeq == 0 || torn || _headCount >= _perSegment) {
+                _ready = rotate();
+            } else {
+                String path = segmentPath(_head);
+                _file = LittleFS.open(path.c_str(), "a");
+                _ready = (bool)_file;
+            }
+            ST_LOG(STORAGE_LOG_INFO, "FS: Log '%s' ready (segment: %u, records: %u)",
+                _base, _head, _headCount);
+            return _ready;
+        }
+
+        /**
+         * Добавить запись в конец журнала
+         * @param rec Запись
+         * @return true если запись дописана
+         */
+        bool append(const R& rec) {
+            if (!_ready) {
+                ST_LOG(STORAGE_LOG_ERROR, "FS: Log '%s' not started", _base);
+                return false;
+            }
+            StorageWriter::IoGuard io;
+            if ((_headCount >= _perSegment || _headTorn) && !rotate()) {
+                _ready = false;
+                return false;
+            }
+
+            Slot slot;
+            memcpy(&slot.data, &rec, sizeof(R));
+            slot.crc = Checksum::calc(&rec, sizeof(R));
+            if (writeSlot(slot)) return true;
+
+            // Часть записи могла остаться в сегменте, и следующие легли бы со сдвигом:
+            // закрываем сегмент (обход возьмет только целые записи) и пробуем в новом -
+            // ротация освобождает самый старый сегмент
+            _headTorn = true;
+            StorageManager::invalidateStats();
+            ST_LOG(STORAGE_LOG_WARNING, "FS: Short write to '%s', rotating", _base);
+            if (!rotate()) {
+                _ready = false;
+                return false;
+            }
+            if (writeSlot(slot)) return true;
+            _headTorn = true;
+            ST_LOG(STORAGE_LOG_ERROR, "FS: Append error for '%s'", _base);
+            return false;
+        }
+
+        /**
+         * Обход записей от самой старой к самой новой.
+         * Обработчик вызывается без блокировки ввода-вывода: из него можно вызывать append()
+         * @param fn Обработчик; вернуть false, чтобы остановить обход
+         * @param ctx Произвольный указатель, передаётся в обработчик
+         */
+        void forEach(bool (*fn)(const R& rec, void* ctx), void* ctx = nullptr) {
+            walk(false, fn, ctx);
+        }
+
+        /**
+         * Обход записей от самой новой к самой старой (обработчик - как в forEach())
+         * @param fn Обработчик; вернуть false, чтобы остановить обход
+         * @param ctx Произвольный указатель, передаётся в обработчик
+         */
+        void forEachReverse(bool (*fn)(const R& rec, void* ctx), void* ctx = nullptr) {
+            walk(true, fn, ctx);
+        }
+
+        /**
+         * Прочитать последние N записей
+         * @param out Массив минимум на n записей; заполняется от старой к новой
+         * @param n Сколько записей нужно
+         * @return Сколько записей прочитано
+         */
+        size_t readLast(R* out, size_t n) {
+            struct Ctx { R* out; size_t n; size_t got; } c = { out, n, 0 };
+            if (!n) return 0;
+            forEachReverse([](const R& rec, void* p) {
+                Ctx* c = (Ctx*)p;
+                memcpy(&c->out[c->n - 1 - c->got], &rec, sizeof(R));
+                return ++c->got < c->n;
+            }, &c);
+            if (c.got < n) memmove(out, out + (n - c.got), c.got * sizeof(R));
+            return c.got;
+        }
+
+        /**
+         * Количество записей в журнале (включая испорченные, которые пропустит обход).
+         * Заголовки читаются под IoGuard - задача-писатель не ротирует сегменты посреди подсчета
+         */
+        size_t count() {
+            if (!_ready) return 0;
+            StorageWriter::IoGuard io;
+            size_t total = _headCount;
+            for (uint8_t back = 1; back < _segments && back < _headSeq; back++) {
+                uint8_t index = (_head + _segments - back) % _segments;
+                SegmentHeader hdr;
+                uint16_t records;
+                bool torn;
+                if (readHeader(index, hdr, records, torn) && hdr.seq == _headSeq - back) total += records;
+            }
+            return total;
+        }
+
+        /**
+         * Удалить все сегменты и начать журнал заново
+         * @return true если журнал готов к записи
+         */
+        bool clear() {
+            StorageWriter::IoGuard io;
+            if (_file) _file.close();
+            for (uint8_t i = 0; i < _segments; i++) {
+                String path = segmentPath(i);
+                if (LittleFS.exists(path.c_str())) StorageManager::removeFile(path.c_str());
+            }
+            _headSeq = 0;
+            _ready = rotate();
+            ST_LOG(STORAGE_LOG_INFO, "FS: Log '%s' cleared", _base);
+            return _ready;
+        }
+    };
+
+
+#endif
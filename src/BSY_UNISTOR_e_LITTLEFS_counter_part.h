@@ -0,0 +1,99 @@
+#ifndef BSY_UNISTOR_E_LITTLEFS_COUNTER_PART_H
+#define BSY_UNISTOR_E_LITTLEFS_COUNTER_PART_H
+
+    /**
+     * @class StorageCounter
+     * @brief Счетчик с частым сохранением (наработка, энергия, циклы) поверх StorageRingLog
+     *
+     * Каждое сохранение дописывает в журнал одну запись с текущим значением
+     * (sizeof(V) + сумма), вместо перезаписи всего блоба в NVS. begin() восстанавливает
+     * значение по последней целой записи: испорченная запись в хвосте теряет только
+     * последнее приращение. Старые сегменты журнала стираются при ротации,
+     * так что отдельное уплотнение не нужно, а запись разносится по сегментам.
+     * @code
+     * StorageCounter<uint64_t> energy("/energy");
+     * void setup() {
+     *     StorageFS::begin();
+     *     energy.begin();
+     * }
+     * void loop() {
+     *     energy.add(wh);   // запись ~12 байт
+     * }
+     * @endcode
+     * @tparam V Тип значения (целое или с плавающей точкой)
+     * @tparam Checksum Политика контрольной суммы записей
+     */
+    template <typename V = uint32_t, typename Checksum = StorageCrc32>
+    class StorageCounter {
+        static_assert(std::is_arithmetic<V>::value, "StorageCounter: only integer or floating point values");
+
+    private:
+        StorageRingLog<V, Checksum> _log;
+        const char* _base;
+        V _value = 0;
+
+    public:
+        /**
+         * Конструктор счетчика
+         * @param baseName Базовый путь сегментов журнала (например "/energy")
+         * @param recordsPerSegment Записей в сегменте (сегмент стирается раз в столько сохранений)
+         * @param segments Количество сегментов (не меньше 2)
+         */
+        StorageCounter(const char* baseName, uint16_t recordsPerSegment = 256, uint8_t segments = 2)
+            : _log(baseName, recordsPerSegment, segments), _base(baseName) {}
+
+        /**
+         * Открыть журнал и восстановить значение (вызывать после StorageFS::begin())
+         * @param initial Значение, если журнал пуст
+         * @return true если журнал готов к записи
+         */
+        bool begin(V initial = 0) {
+            bool ok = _log.begin();
+            V last;
+            if (ok && _log.readLast(&last, 1)) {
+                _value = last;
+                ST_LOG(STORAGE_LOG_INFO, "FS: Counter '%s' restored", _base);
+            } else {
+                _value = initial;
+            }
+            return ok;
+        }
+
+        /**
+         * Прибавить и сохранить
+         * @param delta Приращение
+         * @return true если запись дописана
+         */
+        bool add(V delta) {
+            _value += delta;
+            return _log.append(_value);
+        }
+
+        /**
+         * Установить и сохранить значение
+         * @return true если запись дописана
+         */
+        bool set(V value) {
+            _value = value;
+            return _log.append(_value);
+        }
+
+        /**
+         * @return Текущее значение
+         */
+        V get() const {
+            return _value;
+        }
+
+        /**
+         * Стереть журнал и начать с заданного значения
+         * @return true если журнал готов и значение записано
+         */
+        bool reset(V value = 0) {
+            _value = value;
+            return _log.clear() && _log.append(_value);
+        }
+    };
+
+
+#endif
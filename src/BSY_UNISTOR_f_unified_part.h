@@ -0,0 +1,231 @@
+#ifndef BSY_UNISTOR_F_UNIFIED_PART_H
+#define BSY_UNISTOR_F_UNIFIED_PART_H
+
+    /**
+     * @class StorageTier
+     * @brief Хранилище-бэкенд для Storage<T>: NVS (InFs = false) или LittleFS (InFs = true).
+     * Держит ссылку на RAM-копию Storage<T> и пишет её после дебаунса.
+     * changed() только помечает копию: Storage<T>::edit() зовет его до того, как
+     * вызывающий изменит данные, поэтому запись - всегда в tick()/flush()
+     */
+    template <typename T, bool InFs>
+    class StorageTier;
+
+    /**
+     * Бэкенд NVS: ключ = name (без ведущего '/'), дебаунс здесь, троттлинг - в StorageSmallAkaNVS
+     */
+    template <typename T>
+    class StorageTier<T, false> {
+    private:
+        StorageSmallAkaNVS _nvs;
+        const char* _key;
+        T& _data;
+        uint8_t _version;
+        uint32_t _intervalMs;
+        uint32_t _lastChange = 0;
+        bool _dirty = false;
+
+        bool save() {
+            _dirty = false;
+            if (_nvs.save(_key, _data, _version)) return true;
+            _dirty = true;
+            return false;
+        }
+
+    public:
+        StorageTier(const char* name, uint8_t version, uint32_t intervalSec, const char* nvsNamespace, T& data)
+            : _nvs(nvsNamespace), _key(name[0] == '/' ? name + 1 : name), _data(data),
+            _version(version), _intervalMs(intervalSec * 1000) {}
+
+        bool load(void (*resetFunc)(T&)) {
+            if (_nvs.load(_key, _data, _version)) return true;
+            if (resetFunc) resetFunc(_data);
+            return false;
+        }
+
+        void changed() {
+            _dirty = true;
+            _lastChange = millis();
+        }
+
+        void tick() {
+            if (_dirty && millis() - _lastChange >= _intervalMs) save();
+            _nvs.tick();
+        }
+
+        bool flush() {
+            bool ok = !_dirty || save();
+            return _nvs.flush() && ok;
+        }
+
+        bool isDirty() const {
+            return _dirty || _nvs.hasPending();
+        }
+    };
+
+#if BSY_STORAGE_USE_LITTLEFS
+    /**
+     * Бэкенд LittleFS: файл "/<name>", запись - обычным порядком StorageBigAkaFileSys
+     * (дебаунс, StorageManager::tick(), flushAll(), OTA). Дебаунс включен и при
+     * intervalSec = 0 - запись на ближайшем tick()
+     */
+    template <typename T>
+    class StorageTier<T, true> {
+    private:
+        String _path;   // до _fs: объект файла хранит указатель на строку
+        StorageBigAkaFileSys<T> _fs;
+
+    public:
+        StorageTier(const char* name, uint8_t version, uint32_t intervalSec, const char*, T& data)
+            : _path(name[0] == '/' ? String(name) : String("/") + name),
+            _fs(_path.c_str(), data, intervalSec) {
+            _fs.setVersion(version);
+        }
+
+        bool load(void (*resetFunc)(T&)) { return _fs.load(resetFunc); }
+        void changed() { _fs.update(); }
+        void tick() { _fs.tick(); }
+        bool flush() { return _fs.flush(); }
+        bool isDirty() const { return _fs.isDirty(); }
+
+        /**
+         * Файловый объект для тонкой настройки (setBackgroundWrite, setPriority, ...)
+         */
+        StorageBigAkaFileSys<T>& file() { return _fs; }
+    };
+#endif
+
+    /**
+     * @class Storage
+     * @brief Единый интерфейс хранения: бэкенд выбирается по sizeof(T) при компиляции.
+     * Влезает в NVS (sizeof(T) + 8 <= NVS_MAX_SIZE) - NVS, иначе файл LittleFS.
+     * Данные живут в RAM-копии: get() после первой загрузки флеш не читает,
+     * изменения пишутся обратно после дебаунса
+     * @code
+     * Storage<Settings> settings("settings");
+     * void setup() { settings.begin(resetSettings); }
+     * void loop() {
+     *     int port = settings->port;          // из RAM
+     *     settings.edit().port = 8080;        // пометить и изменить
+     *     settings.tick();                    // запись (после дебаунса)
+     * }
+     * @endcode
+     * @tparam T Тип хранимых данных
+     */
+    template <typename T>
+    class Storage {
+    public:
+        static constexpr bool IN_NVS = !BSY_STORAGE_USE_LITTLEFS || sizeof(T) + 8 <= NVS_MAX_SIZE;
+
+    private:
+        T _data{};           // RAM-копия, до _tier: бэкенд держит на неё ссылку
+        StorageTier<T, !IN_NVS> _tier;
+        void (*_resetFunc)(T&) = nullptr;
+        bool _loaded = false;
+        bool _loadOk = false;
+
+        bool ensureLoaded() {
+            if (_loaded) return _loadOk;
+            _loaded = true;
+            _loadOk = _tier.load(_resetFunc);
+            return _loadOk;
+        }
+
+    public:
+        /**
+         * Конструктор
+         * @param name Ключ NVS (max 15 символов) или имя файла ("/<name>") - по бэкенду
+         * @param version Версия данных
+         * @param intervalSec Время выдержки перед записью в секундах (0 - на ближайшем tick())
+         * @param nvsNamespace Неймспейс NVS (для бэкенда NVS)
+         */
+        Storage(const char* name, uint8_t version = 1, uint32_t intervalSec = 5,
+                const char* nvsNamespace = STORAGE_UNIFIED_NAMESPACE)
+            : _tier(name, version, intervalSec, nvsNamespace, _data) {}
+
+        /**
+         * Загрузка (сейчас или, при lazy, при первом get()/edit())
+         * @param resetFunc Функция для сброса данных, если сохраненных нет или они испорчены
+         * @param lazy Отложить чтение до первого обращения
+         * @return true если данные загружены (при lazy - всегда true)
+         */
+        bool begin(void (*resetFunc)(T&) = nullptr, bool lazy = false) {
+            _resetFunc = resetFunc;
+            _loaded = false;
+            return lazy || ensureLoaded();
+        }
+
+        /**
+         * Данные из RAM (при первом обращении - загрузка)
+         */
+        const T& get() {
+            ensureLoaded();
+            return _data;
+        }
+
+        const T* operator->() {
+            return &get();
+        }
+
+        /**
+         * Доступ на изменение: объект помечается измененным и запишется в tick() после
+         * дебаунса (или в flush()) - уже с изменениями, сделанными через ссылку
+         * @return Ссылка на RAM-копию
+         */
+        T& edit() {
+            ensureLoaded();
+            _tier.changed();
+            return _data;
+        }
+
+        /**
+         * Заменить значение; одинаковое значение не помечает объект измененным
+         * @return true если значение изменилось
+         */
+        bool set(const T& value) {
+            ensureLoaded();
+            if (!memcmp(&_data, &value, sizeof(T))) return false;
+            memcpy(&_data, &value, sizeof(T));
+            _tier.changed();
+            return true;
+        }
+
+        /**
+         * Запись изменений по истечении дебаунса (вызывать в loop())
+         */
+        void tick() {
+            _tier.tick();
+        }
+
+        /**
+         * Записать изменения сейчас
+         * @return true если несохраненных изменений не осталось
+         */
+        bool flush() {
+            return _tier.flush();
+        }
+
+        /**
+         * @return true если есть несохраненные изменения
+         */
+        bool isDirty() const {
+            return _tier.isDirty();
+        }
+
+        /**
+         * @return true если данные загружены успешно (а не из resetFunc)
+         */
+        bool isLoaded() const {
+            return _loaded && _loadOk;
+        }
+
+        /**
+         * Бэкенд (для LittleFS - tier().file() дает StorageBigAkaFileSys)
+         */
+        StorageTier<T, !IN_NVS>& tier() {
+            return _tier;
+        }
+    };
+
+
+#endif
@@ -0,0 +1,201 @@
+// Замеры производительности библиотеки на плате: задержка load/save и пропускная способность
+// для разных размеров, стоимость tick(), расход кучи. Итог - строками CSV с префиксом "BENCH,":
+// BENCH,<backend>,<op>,<size>,<iters>,<min_us>,<avg_us>,<max_us>,<kb_per_s>
+// BENCH,heap,<stage>,<free>,<min_free>,<max_alloc>,<frag_%>
+// Сравнивать версии библиотеки - по этим строкам (grep BENCH, в таблицу)
+
+// Журнал ниже ERROR вырезается при компиляции и не влияет на замеры
+#define STORAGE_LOG_LEVEL STORAGE_LOG_ERROR
+#include "BSY_ESP32_UniversalStorages.h"
+#include <esp_timer.h>
+
+static const int ITERS = 5;  // повторов каждой операции
+
+/// @brief min/avg/max одной серии замеров
+struct Series {
+    uint32_t minUs = UINT32_MAX;
+    uint32_t maxUs = 0;
+    uint64_t totalUs = 0;
+    int count = 0;
+
+    void add(uint32_t us) {
+        if (us < minUs) minUs = us;
+        if (us > maxUs) maxUs = us;
+        totalUs += us;
+        count++;
+    }
+
+    uint32_t avgUs() const { return count ? (uint32_t)(totalUs / count) : 0; }
+};
+
+// size - байт (для tick - число объектов, тогда throughput = false и КБ/с пустые)
+static void report(const char* backend, const char* op, size_t size, const Series& s, bool throughput = true) {
+    if (!s.count) {
+        Serial.printf("BENCH,%s,%s,%u,0,,,,\n", backend, op, (uint32_t)size);
+        return;
+    }
+    // байт за микросекунду * 1e6 / 1024 = КБ/с
+    float kbps = throughput && s.avgUs() ? size * 1000000.0f / 1024.0f / s.avgUs() : 0;
+    Serial.printf("BENCH,%s,%s,%u,%d,%u,%u,%u,%.1f\n", backend, op, (uint32_t)size, s.count,
+                  s.minUs, s.avgUs(), s.maxUs, kbps);
+}
+
+static void reportHeap(const char* stage) {
+    uint32_t freeHeap = ESP.getFreeHeap();
+    uint32_t maxAlloc = ESP.getMaxAllocHeap();
+    // Фрагментация: какая часть свободной кучи недоступна одним куском
+    uint32_t frag = freeHeap ? 100 - (uint32_t)((uint64_t)maxAlloc * 100 / freeHeap) : 0;
+    Serial.printf("BENCH,heap,%s,%u,%u,%u,%u\n", stage, freeHeap, ESP.getMinFreeHeap(), maxAlloc, frag);
+}
+
+template <size_t N>
+struct Blob {
+    uint8_t d[N];
+};
+
+StorageSmallAkaNVS nvsBench("bench");
+
+/// @brief NVS: save (данные каждый раз другие, иначе запись пропустит кэш CRC) и load
+template <size_t N>
+void benchNvs() {
+    Blob<N> blob;
+    Series save, load;
+    for (int i = 0; i < ITERS; i++) {
+        memset(blob.d, i + 1, N);
+        int64_t t = esp_timer_get_time();
+        bool ok = nvsBench.save("blob", blob, 1, true);  // force: без защиты от частых записей
+        if (ok) save.add((uint32_t)(esp_timer_get_time() - t));
+
+        t = esp_timer_get_time();
+        ok = nvsBench.load("blob", blob, 1);
+        if (ok) load.add((uint32_t)(esp_timer_get_time() - t));
+    }
+    report("nvs", "save", N, save);
+    report("nvs", "load", N, load);
+    nvsBench.remove("blob");
+}
+
+/// @brief LittleFS: save и load объекта; большие объекты - в PSRAM, если она есть
+template <size_t N>
+void benchFs() {
+    typedef Blob<N> Data;
+    Data* blob = (Data*)(psramFound() ? ps_malloc(sizeof(Data)) : malloc(sizeof(Data)));
+    Series save, load;
+    if (!blob) {
+        report("fs", "save", N, save);  // не хватило памяти - пустая строка
+        report("fs", "load", N, load);
+        return;
+    }
+    {
+        StorageBigAkaFileSys<Data> fs("/bench.bin", *blob, 0);
+        for (int i = 0; i < ITERS; i++) {
+            memset(blob->d, i + 1, N);
+            fs.update();
+            int64_t t = esp_timer_get_time();
+            bool ok = fs.save();
+            if (ok) save.add((uint32_t)(esp_timer_get_time() - t));
+
+            t = esp_timer_get_time();
+            ok = fs.load();
+            if (ok) load.add((uint32_t)(esp_timer_get_time() - t));
+        }
+        fs.remove();
+    }
+    free(blob);
+    report("fs", "save", N, save);
+    report("fs", "load", N, load);
+}
+
+/// @brief Стоимость tick(), когда писать нечего и когда изменения ждут дебаунса
+void benchTick() {
+    const int CALLS = 1000;
+    static Blob<64> small;
+    static Blob<1024> data[8];
+    StorageBigAkaFileSys<Blob<1024>> files[8] = {
+        { "/tick0.bin", data[0], 3600 }, { "/tick1.bin", data[1], 3600 },
+        { "/tick2.bin", data[2], 3600 }, { "/tick3.bin", data[3], 3600 },
+        { "/tick4.bin", data[4], 3600 }, { "/tick5.bin", data[5], 3600 },
+        { "/tick6.bin", data[6], 3600 }, { "/tick7.bin", data[7], 3600 },
+    };
+
+    Series idle, pending, nvsIdle, nvsPending;
+    for (int i = 0; i < CALLS; i++) {
+        int64_t t = esp_timer_get_time();
+        StorageManager::tick();
+        idle.add((uint32_t)(esp_timer_get_time() - t));
+    }
+
+    for (auto& f : files) f.update();  // срок записи - через час, tick() только проверяет
+    for (int i = 0; i < CALLS; i++) {
+        int64_t t = esp_timer_get_time();
+        StorageManager::tick();
+        pending.add((uint32_t)(esp_timer_get_time() - t));
+    }
+
+    for (int i = 0; i < CALLS; i++) {
+        int64_t t = esp_timer_get_time();
+        nvsBench.tick();
+        nvsIdle.add((uint32_t)(esp_timer_get_time() - t));
+    }
+
+    // Две записи подряд: вторая откладывается защитой от частых записей и ждет tick()
+    small.d[0] = 1;
+    nvsBench.save("tick", small, 1);
+    small.d[0] = 2;
+    nvsBench.save("tick", small, 1);
+    for (int i = 0; i < CALLS; i++) {
+        int64_t t = esp_timer_get_time();
+        nvsBench.tick();
+        nvsPending.add((uint32_t)(esp_timer_get_time() - t));
+    }
+    nvsBench.flush();
+    nvsBench.remove("tick");
+
+    report("manager", "tick_idle", 8, idle, false);
+    report("manager", "tick_pending", 8, pending, false);
+    report("nvs", "tick_idle", 1, nvsIdle, false);
+    report("nvs", "tick_pending", 1, nvsPending, false);
+}
+
+void setup() {
+    Serial.begin(115200);
+    while (!Serial && millis() < 5000);
+    delay(2000);
+
+    Serial.printf("BENCH,version,%s\n", BASAY_UNIVERSALSTORAGES_VERSION);
+    Serial.println("BENCH,columns,backend,op,size,iters,min_us,avg_us,max_us,kb_per_s");
+    reportHeap("start");
+
+    StorageFS::begin();
+    reportHeap("fs_mounted");
+
+    benchNvs<1>();
+    benchNvs<16>();
+    benchNvs<64>();
+    benchNvs<256>();
+    benchNvs<1024>();
+    benchNvs<2048>();
+    benchNvs<NVS_MAX_SIZE - 8>();  // самый большой пакет NVS
+    reportHeap("nvs_done");
+
+    benchFs<1024>();
+    benchFs<4096>();
+    benchFs<16384>();
+    benchFs<65536>();
+    benchFs<262144>();  // без PSRAM, скорее всего, не хватит кучи
+    reportHeap("fs_done");
+
+    benchTick();
+    reportHeap("tick_done");
+
+#ifdef STORAGE_METRICS
+    StorageMetrics m = StorageMetricsSource::total();
+    Serial.printf("BENCH,metrics,saves=%u,loads=%u,throttled=%u,skipped=%u,bytes=%llu\n",
+                  m.save.count, m.load.count, m.throttled, m.skipped, (unsigned long long)m.bytesWritten);
+#endif
+    Serial.println("BENCH,done");
+}
+
+void loop() {
+    delay(1000);
+}
@@ -52,7 +52,6 @@ void setup() {
     int hui=0;
     bool resNoNamespc =nvsTestNoNamespace.load("hui",hui,1);
     Serial.printf("Load unknown key from no namespace: %s\n", resNoNamespc==false ? "OK" : "---------------------FAIL");
-    delay(1100);
 
 
 
@@ -62,17 +61,14 @@ void setup() {
     // 1. Сохраняем bool (ключ "bool")
     bool resBool = nvsTest.save("bool", bTest,1);
     Serial.printf("Save bool: %s\n", resBool ? "OK" : "---------------------FAIL");
-    delay(1100);
 
     // 2. Сохраняем int (ключ "int")
     bool resInt = nvsTest.save("int", iTest,1);
     Serial.printf("Save int: %s\n", resInt ? "OK" : "---------------------FAIL");
-    delay(1100);
 
     // 3. Сохраняем float (ключ "float")
     bool resFloat = nvsTest.save("float", fTest,1);
     Serial.printf("Save float: %s\n", resFloat ? "OK" : "---------------------FAIL");
-    delay(1100);
 
     // 4. Сохраняем структуру (ключ "struct", форсированно)
     bool resStruct = nvsTest.save("struct", sTest, 1, true); 
@@ -80,6 +76,9 @@ void setup() {
 
     Serial.println("\n--- ЭТАП 2: ПРОВЕРКА (ЗАГРУЗКА) ---");
 
+    // Все загрузки этапа идут в одной пакетной сессии (неймспейс открывается один раз)
+    nvsTest.beginBatch();
+
     // ПРОВЕРКА BOOL
     bool bRead = false;
     if (nvsTest.load("bool", bRead,1)) {
@@ -121,6 +120,8 @@ void setup() {
         Serial.println("Load struct: FAILED");
     }
 
+    nvsTest.endBatch();
+
     testStackCrash();
 
     Serial.println("\n--- ТЕСТ ЗАВЕРШЕН ---");
@@ -131,6 +132,7 @@ void setup() {
 }
 
 void loop(){
+    nvsTest.tick();
     if (millis() - imAlive > 10000) {
         imAlive = millis();
         Serial.print("im alive " );